@@ -0,0 +1,443 @@
+/**
+ *  @file   app_bridge.c
+ *  @brief  Bridged multi-segment LAN simulation
+ *
+ *  Every segment is its own simulator instance with its own shared bus and runs on its own
+ *  thread. Segments only talk through bridge inboxes. A frame forwarded at time t shows up on
+ *  the neighbouring port at t + T_trans + bridgeDelay, so bridgeDelay is the lookahead:
+ *  a segment may process an event at time t once every neighbour has promised (lbts) not to
+ *  send anything before t - bridgeDelay.
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "app_bridge.h"
+#include "app_simulator.h"
+#include "timestamp_generator.h"
+#include "queue.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <float.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define APP_BRIDGE_INBOX_SIZE (1 << 20)
+#define APP_BRIDGE_LEFT       (0)
+#define APP_BRIDGE_RIGHT      (1)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef struct
+{
+    app_simulator_data_S* sim;
+    int                   index;
+    int                   ports[2];   // Port node facing each neighbour, -1 at the ends of the chain
+    timestamp_rng_S       rng;        // Forwarding decisions
+    pthread_t             thread;
+
+    // SHARED WITH NEIGHBOURS
+    pthread_mutex_t       lock;
+    pthread_cond_t        cond;
+    Queue*                inbox[2];   // Frames from each neighbour, guarded by lock
+    bool                  done;       // Guarded by lock
+    uint64_t              frames_received; // Frames that could change the next event, guarded by lock
+    uint64_t              frames_seen;     // Guarded by lock
+    _Atomic double        lbts;       // Lower bound on the time of any frame this segment still sends
+    _Atomic double        wait_until; // Time the segment is blocked on, DBL_MAX while running
+    atomic_bool           waiting;
+
+    // METRICS
+    double                forwarded_frames;
+    double                delivered_frames;
+    double                dropped_frames;
+    double                lost_frames; // Reached the segment after it finished, guarded by lock
+} app_bridge_segment_S;
+
+typedef struct
+{
+    app_bridge_config_S   config;
+    double                T_trans;
+    app_bridge_segment_S* segments;
+} app_bridge_data_S;
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Neighbour on one side of a segment, NULL at the ends of the chain
+ */
+static app_bridge_segment_S* app_bridge_neighbour(const app_bridge_segment_S* seg, int side);
+
+/**
+ * @brief Latest time up to which no frame can still arrive from the neighbours
+ */
+static double app_bridge_safe_time(const app_bridge_segment_S* seg);
+
+/**
+ * @brief Raise the published lower bound of a segment and wake neighbours waiting on it.
+ *        A running segment only wakes neighbours it unblocks, a segment about to block
+ *        wakes them all so they can pass its new bound on
+ */
+static void app_bridge_publish(app_bridge_segment_S* seg, double lbts, bool blocking);
+
+/**
+ * @brief Hand a frame to a segment's inbox
+ */
+static void app_bridge_send(app_bridge_segment_S* seg, app_bridge_segment_S* target, int side, double time);
+
+/**
+ * @brief Move frames that have arrived by the next event onto the port nodes of a segment
+ * @return Time of the next event
+ */
+static double app_bridge_drain(app_bridge_segment_S* seg);
+
+/**
+ * @brief Successful transmission on a segment, forward station frames across a bridge
+ */
+static void app_bridge_tx_callback(void* ctx, int node, double time);
+
+/**
+ * @brief Event loop of a single segment
+ */
+static void* app_bridge_segment_thread(void* arg);
+
+/*************************************************************************
+ *            P R I V A T E   D A T A   D E C L A R A T I O N S          *
+ *************************************************************************/
+
+static app_bridge_data_S app_bridge_data;
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static app_bridge_segment_S* app_bridge_neighbour(const app_bridge_segment_S* seg, int side)
+{
+    int index = (side == APP_BRIDGE_LEFT) ? seg->index - 1 : seg->index + 1;
+
+    if (index < 0 || index >= app_bridge_data.config.segments)
+    {
+        return NULL;
+    }
+    return &app_bridge_data.segments[index];
+}
+
+static double app_bridge_safe_time(const app_bridge_segment_S* seg)
+{
+    double safeTime = DBL_MAX;
+
+    for (int side = APP_BRIDGE_LEFT; side <= APP_BRIDGE_RIGHT; side++)
+    {
+        app_bridge_segment_S* neighbour = app_bridge_neighbour(seg, side);
+        if (neighbour == NULL)
+        {
+            continue;
+        }
+
+        double neighbourTime = atomic_load(&neighbour->lbts) + app_bridge_data.config.bridgeDelay;
+        if (neighbourTime < safeTime)
+        {
+            safeTime = neighbourTime;
+        }
+    }
+    return safeTime;
+}
+
+static void app_bridge_publish(app_bridge_segment_S* seg, double lbts, bool blocking)
+{
+    if (lbts <= atomic_load(&seg->lbts))
+    {
+        return;
+    }
+    atomic_store(&seg->lbts, lbts);
+
+    // Only take the neighbour's lock when it is actually blocked on us
+    for (int side = APP_BRIDGE_LEFT; side <= APP_BRIDGE_RIGHT; side++)
+    {
+        app_bridge_segment_S* neighbour = app_bridge_neighbour(seg, side);
+        if (neighbour != NULL && atomic_load(&neighbour->waiting) &&
+            (blocking || lbts + app_bridge_data.config.bridgeDelay >= atomic_load(&neighbour->wait_until)))
+        {
+            pthread_mutex_lock(&neighbour->lock);
+            pthread_cond_broadcast(&neighbour->cond);
+            pthread_mutex_unlock(&neighbour->lock);
+        }
+    }
+}
+
+static void app_bridge_send(app_bridge_segment_S* seg, app_bridge_segment_S* target, int side, double time)
+{
+    seg->forwarded_frames++;
+
+    pthread_mutex_lock(&target->lock);
+    if (!target->done)
+    {
+        if (Queue_Enqueue(target->inbox[side], time) == -1)
+        {
+            seg->dropped_frames++;
+        }
+        else if (time < atomic_load(&target->wait_until))
+        {
+            target->frames_received++;
+            pthread_cond_broadcast(&target->cond);
+        }
+    }
+    else
+    {
+        target->lost_frames++;
+    }
+    pthread_mutex_unlock(&target->lock);
+}
+
+static double app_bridge_drain(app_bridge_segment_S* seg)
+{
+    double nextTime;
+
+    // Frames only move onto a port once they have arrived, which keeps a segment's history
+    // independent of how far ahead its neighbours happen to be running
+    pthread_mutex_lock(&seg->lock);
+    while (true)
+    {
+        int side = -1;
+        double frameTime = DBL_MAX;
+
+        nextTime = app_simulator_next_time(seg->sim);
+        for (int i = APP_BRIDGE_LEFT; i <= APP_BRIDGE_RIGHT; i++)
+        {
+            if (!Queue_IsEmpty(seg->inbox[i]) && Queue_PeekHead(seg->inbox[i]) < frameTime)
+            {
+                frameTime = Queue_PeekHead(seg->inbox[i]);
+                side = i;
+            }
+        }
+
+        if (side < 0 || nextTime < 0 || frameTime > nextTime)
+        {
+            break;
+        }
+        if (!app_simulator_port_enqueue(seg->sim, seg->ports[side], Queue_Dequeue(seg->inbox[side])))
+        {
+            seg->dropped_frames++;
+        }
+    }
+    seg->frames_seen = seg->frames_received;
+    pthread_mutex_unlock(&seg->lock);
+
+    return nextTime;
+}
+
+static void app_bridge_tx_callback(void* ctx, int node, double time)
+{
+    app_bridge_segment_S* seg = ctx;
+    app_bridge_segment_S* left = app_bridge_neighbour(seg, APP_BRIDGE_LEFT);
+    app_bridge_segment_S* right = app_bridge_neighbour(seg, APP_BRIDGE_RIGHT);
+    double arrival = time + app_bridge_data.T_trans + app_bridge_data.config.bridgeDelay;
+
+    // Frames coming off a port have reached their segment
+    if (node == seg->ports[APP_BRIDGE_LEFT] || node == seg->ports[APP_BRIDGE_RIGHT])
+    {
+        seg->delivered_frames++;
+        return;
+    }
+
+    double u_rand = (double)timestamp_rng_next(&seg->rng) / (double)RAND_MAX;
+    if (u_rand >= app_bridge_data.config.forwardProbability ||
+        arrival >= app_bridge_data.config.simulationTimeSec ||
+        (left == NULL && right == NULL))
+    {
+        return;
+    }
+
+    // Pick a side, a coin flip when both bridges exist
+    if (left != NULL && (right == NULL || timestamp_rng_next(&seg->rng) % 2 == 0))
+    {
+        app_bridge_send(seg, left, APP_BRIDGE_RIGHT, arrival);
+    }
+    else
+    {
+        app_bridge_send(seg, right, APP_BRIDGE_LEFT, arrival);
+    }
+}
+
+static void* app_bridge_segment_thread(void* arg)
+{
+    app_bridge_segment_S* seg = arg;
+
+    while (true)
+    {
+        // Read the neighbours' bounds before draining, a frame still on its way is covered by them
+        double safeTime = app_bridge_safe_time(seg);
+        double nextTime = app_bridge_drain(seg);
+
+        if (nextTime < 0)
+        {
+            // Next step completes the simulation
+            app_simulator_step(seg->sim);
+            break;
+        }
+
+        // Anything still in the inbox is later than nextTime so it does not lower the bound
+        if (nextTime <= safeTime)
+        {
+            app_bridge_publish(seg, nextTime, false);
+            if (app_simulator_step(seg->sim) < 0)
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Blocked on a neighbour. Flag it before publishing, a neighbour that blocks at the
+        // same time then either sees the flag and wakes us or we see its new bound below
+        atomic_store(&seg->wait_until, nextTime);
+        atomic_store(&seg->waiting, true);
+        app_bridge_publish(seg, safeTime, true);
+
+        pthread_mutex_lock(&seg->lock);
+        if (seg->frames_seen == seg->frames_received && app_bridge_safe_time(seg) <= safeTime)
+        {
+            pthread_cond_wait(&seg->cond, &seg->lock);
+        }
+        pthread_mutex_unlock(&seg->lock);
+        atomic_store(&seg->waiting, false);
+        atomic_store(&seg->wait_until, DBL_MAX);
+    }
+
+    // Frames still in the inbox were due after the last event, they are lost like later ones
+    pthread_mutex_lock(&seg->lock);
+    seg->done = true;
+    for (int i = APP_BRIDGE_LEFT; i <= APP_BRIDGE_RIGHT; i++)
+    {
+        while (!Queue_IsEmpty(seg->inbox[i]))
+        {
+            Queue_Dequeue(seg->inbox[i]);
+            seg->lost_frames++;
+        }
+    }
+    pthread_mutex_unlock(&seg->lock);
+    app_bridge_publish(seg, DBL_MAX, true);
+
+    return NULL;
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+bool app_bridge_init(const app_bridge_config_S* config)
+{
+    memset(&app_bridge_data, 0, sizeof(app_bridge_data));
+
+    app_bridge_data.config = *config;
+    app_bridge_data.T_trans = config->L/config->R;
+    app_bridge_data.segments = calloc(config->segments, sizeof(app_bridge_segment_S));
+    if (app_bridge_data.segments == NULL)
+    {
+        fprintf(stderr, "Not enough memory for %d segments\r\n", config->segments);
+        return false;
+    }
+
+    for (int i = 0; i < config->segments; i++)
+    {
+        app_bridge_segment_S* seg = &app_bridge_data.segments[i];
+
+        seg->index = i;
+        seg->sim = app_simulator_create(config->simulationTimeSec, config->A, config->L, config->R,
+                                        config->N, config->D, config->S, config->seed + i);
+        timestamp_rng_seed(&seg->rng, ~(config->seed + i));
+        pthread_mutex_init(&seg->lock, NULL);
+        pthread_cond_init(&seg->cond, NULL);
+        atomic_init(&seg->lbts, 0.0);
+        atomic_init(&seg->wait_until, DBL_MAX);
+        atomic_init(&seg->waiting, false);
+
+        // One port per bridge, at the end of the bus facing it. The left port goes in first,
+        // putting it in front moves the stations up one index and would move a right port too.
+        // Ports hold no more frames than the inbox feeding them
+        bool allocated = (seg->sim != NULL);
+        for (int side = APP_BRIDGE_LEFT; side <= APP_BRIDGE_RIGHT; side++)
+        {
+            seg->ports[side] = -1;
+            seg->inbox[side] = Queue_Init(APP_BRIDGE_INBOX_SIZE, side);
+            allocated = allocated && seg->inbox[side] != NULL;
+            if (allocated && app_bridge_neighbour(seg, side) != NULL)
+            {
+                seg->ports[side] = app_simulator_add_port(seg->sim, APP_BRIDGE_INBOX_SIZE, side == APP_BRIDGE_LEFT);
+                allocated = seg->ports[side] >= 0;
+            }
+        }
+        if (!allocated)
+        {
+            fprintf(stderr, "Not enough memory for segment %d\r\n", i);
+            app_bridge_data.config.segments = i + 1;
+            app_bridge_deinit();
+            return false;
+        }
+
+        app_simulator_set_tx_callback(seg->sim, app_bridge_tx_callback, seg);
+    }
+    return true;
+}
+
+void app_bridge_run(void)
+{
+    for (int i = 0; i < app_bridge_data.config.segments; i++)
+    {
+        pthread_create(&app_bridge_data.segments[i].thread, NULL, app_bridge_segment_thread, &app_bridge_data.segments[i]);
+    }
+    for (int i = 0; i < app_bridge_data.config.segments; i++)
+    {
+        pthread_join(app_bridge_data.segments[i].thread, NULL);
+    }
+}
+
+void app_bridge_deinit(void)
+{
+    for (int i = 0; i < app_bridge_data.config.segments; i++)
+    {
+        app_bridge_segment_S* seg = &app_bridge_data.segments[i];
+
+        app_simulator_destroy(seg->sim);
+        Queue_Delete(seg->inbox[APP_BRIDGE_LEFT]);
+        Queue_Delete(seg->inbox[APP_BRIDGE_RIGHT]);
+        pthread_mutex_destroy(&seg->lock);
+        pthread_cond_destroy(&seg->cond);
+    }
+    free(app_bridge_data.segments);
+    app_bridge_data.segments = NULL;
+}
+
+void app_bridge_print_results(void)
+{
+    app_simulator_results_S results;
+    app_simulator_results_S total = {0};
+
+    for (int i = 0; i < app_bridge_data.config.segments; i++)
+    {
+        app_bridge_segment_S* seg = &app_bridge_data.segments[i];
+
+        app_simulator_get_results(seg->sim, &results);
+        total.transmitted_packets += results.transmitted_packets;
+        total.successfully_transmitted_packets += results.successfully_transmitted_packets;
+
+        printf("Segment %d\r\n", i);
+        printf("  Transmitted packets %f\r\n", results.transmitted_packets);
+        printf("  Success packets %f\r\n", results.successfully_transmitted_packets);
+        printf("  Forwarded frames %f\r\n", seg->forwarded_frames);
+        printf("  Delivered frames %f\r\n", seg->delivered_frames);
+        printf("  Dropped frames %f\r\n", seg->dropped_frames);
+        printf("  Lost frames %f\r\n", seg->lost_frames);
+    }
+    printf("Transmitted packets %f\r\n", total.transmitted_packets);
+    printf("Success packets %f\r\n", total.successfully_transmitted_packets);
+}
@@ -0,0 +1,68 @@
+/**
+ *  @file   app_bridge.h
+ *  @brief  API for the bridged multi-segment LAN simulation
+ */
+
+#ifndef APP_BRIDGE_H
+#define APP_BRIDGE_H
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+/**
+ *  @brief  Bridged LAN parameters. Segments form a chain, neighbouring segments are joined
+ *          by a bridge with one port node on each side
+ */
+typedef struct
+{
+    double       simulationTimeSec;
+    double       A;
+    double       L;
+    double       R;
+    int          N;                  // Station nodes per segment, ports come on top
+    double       D;
+    double       S;
+    int          segments;
+    double       bridgeDelay;        // Store-and-forward delay, must be > 0, it is also the lookahead
+    double       forwardProbability; // Chance a station packet is forwarded to a neighbouring segment
+    unsigned int seed;
+} app_bridge_config_S;
+
+/*************************************************************************
+ *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ *  @brief  Initialize the bridged simulation, one simulator instance per segment
+ *  @return False if there is not enough memory for the bridge queues
+ */
+bool app_bridge_init(const app_bridge_config_S* config);
+
+/**
+ *  @brief  De-initialize the bridged simulation
+ */
+void app_bridge_deinit(void);
+
+/**
+ *  @brief  Run every segment on its own thread until all of them complete
+ */
+void app_bridge_run(void);
+
+/**
+ *  @brief  Output per-segment and total results
+ */
+void app_bridge_print_results(void);
+
+#endif /* APP_BRIDGE_H */
@@ -0,0 +1,271 @@
+/**
+ *  @file   app_record.c
+ *  @brief  Columnar record of a single run
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "app_record.h"
+#include "results_file.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define APP_RECORD_PATH_SIZE (4096)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef struct
+{
+    app_record_config_S         config;
+    const app_simulator_data_S* sim;
+    int64_t                     run;
+    struct timespec             start;
+    results_file_writer_S*      summary;
+    results_file_writer_S*      nodes;
+    results_file_writer_S*      intervals;
+    int64_t                     interval;       // Index of the interval being recorded
+    double                      interval_end;
+    uint64_t                    interval_events;    // Events before the interval began
+    app_simulator_results_S     interval_results;   // Metrics before the interval began
+    int64_t*                    backlog;
+    bool                        ok;
+} app_record_data_S;
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Open one of the run's results files, path plus suffix
+ */
+static results_file_writer_S* app_record_open(const char* suffix, const results_file_column_S* columns, int column_count);
+
+/**
+ * @brief Total backlog over all nodes at a sim time
+ */
+static int64_t app_record_backlog(double time);
+
+/**
+ * @brief Add the row of the current interval, ending it at end
+ */
+static void app_record_interval(double end, uint64_t events);
+
+/*************************************************************************
+ *            P R I V A T E   D A T A   D E C L A R A T I O N S          *
+ *************************************************************************/
+
+static app_record_data_S app_record_data;
+
+static const results_file_column_S app_record_summary_columns[] = {
+    { "run",         RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "seed",        RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "simTime",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "A",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "L",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "R",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "N",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "D",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "S",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "endTime",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "events",      RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "transmitted", RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "success",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "dropped",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "collisions",  RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "wallSecs",    RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_PLAIN },
+};
+
+static const results_file_column_S app_record_node_columns[] = {
+    { "run",         RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "node",        RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "transmitted", RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "success",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "dropped",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "collisions",  RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "backlog",     RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+};
+
+static const results_file_column_S app_record_interval_columns[] = {
+    { "run",         RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "interval",    RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "start",       RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "end",         RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "events",      RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+    { "transmitted", RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "success",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "dropped",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "collisions",  RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+    { "backlog",     RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+};
+
+#define APP_RECORD_COLUMN_COUNT(columns) ((int)(sizeof(columns)/sizeof(columns[0])))
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static results_file_writer_S* app_record_open(const char* suffix, const results_file_column_S* columns, int column_count)
+{
+    char path[APP_RECORD_PATH_SIZE];
+
+    snprintf(path, sizeof(path), "%s%s", app_record_data.config.path, suffix);
+    results_file_writer_S* writer = results_file_open_writer(path, columns, column_count, RESULTS_FILE_DEFAULT_BLOCK_ROWS);
+    if (writer == NULL)
+    {
+        fprintf(stderr, "Cannot append to results file %s\r\n", path);
+    }
+    return writer;
+}
+
+static int64_t app_record_backlog(double time)
+{
+    int64_t total = 0;
+
+    app_simulator_get_backlog(app_record_data.sim, time, app_record_data.backlog);
+    for (int i = 0; i < app_simulator_node_count(app_record_data.sim); i++)
+    {
+        total += app_record_data.backlog[i];
+    }
+    return total;
+}
+
+static void app_record_interval(double end, uint64_t events)
+{
+    app_simulator_results_S now;
+    app_simulator_results_S* before = &app_record_data.interval_results;
+
+    app_simulator_get_results(app_record_data.sim, &now);
+    results_file_value_U row[] = {
+        { .i = app_record_data.run },
+        { .i = app_record_data.interval },
+        { .d = app_record_data.interval*app_record_data.config.interval },
+        { .d = end },
+        { .i = events - app_record_data.interval_events },
+        { .d = now.transmitted_packets - before->transmitted_packets },
+        { .d = now.successfully_transmitted_packets - before->successfully_transmitted_packets },
+        { .d = now.dropped_packets - before->dropped_packets },
+        { .d = now.collisions - before->collisions },
+        { .i = app_record_backlog(end) },
+    };
+    app_record_data.ok = results_file_append_row(app_record_data.intervals, row) && app_record_data.ok;
+
+    app_record_data.interval++;
+    app_record_data.interval_end = (app_record_data.interval + 1)*app_record_data.config.interval;
+    app_record_data.interval_events = events;
+    app_record_data.interval_results = now;
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+bool app_record_init(const app_record_config_S* config, const app_simulator_data_S* sim)
+{
+    struct timespec now;
+
+    memset(&app_record_data, 0, sizeof(app_record_data));
+    app_record_data.config = *config;
+    app_record_data.sim = sim;
+
+    if (config->interval <= 0)
+    {
+        fprintf(stderr, "Record interval must be > 0\r\n");
+        return false;
+    }
+
+    app_record_data.summary = app_record_open("", app_record_summary_columns, APP_RECORD_COLUMN_COUNT(app_record_summary_columns));
+    app_record_data.nodes = app_record_open(".nodes", app_record_node_columns, APP_RECORD_COLUMN_COUNT(app_record_node_columns));
+    app_record_data.intervals = app_record_open(".intervals", app_record_interval_columns, APP_RECORD_COLUMN_COUNT(app_record_interval_columns));
+    if (app_record_data.summary == NULL || app_record_data.nodes == NULL || app_record_data.intervals == NULL)
+    {
+        // Nothing was buffered, so closing writes nothing
+        results_file_close_writer(app_record_data.summary);
+        results_file_close_writer(app_record_data.nodes);
+        results_file_close_writer(app_record_data.intervals);
+        return false;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    app_record_data.run = (int64_t)now.tv_sec*1000000000 + now.tv_nsec;
+    clock_gettime(CLOCK_MONOTONIC, &app_record_data.start);
+    app_record_data.interval_end = config->interval;
+    app_record_data.backlog = malloc(app_simulator_node_count(sim)*sizeof(int64_t));
+    app_record_data.ok = true;
+    return true;
+}
+
+void app_record_event(double time, uint64_t events)
+{
+    while (time >= app_record_data.interval_end)
+    {
+        app_record_interval(app_record_data.interval_end, events);
+    }
+}
+
+bool app_record_finish(double endTime, uint64_t events)
+{
+    app_simulator_results_S results;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // The last interval ends with the run, short unless the run ends on a boundary
+    if (endTime > app_record_data.interval*app_record_data.config.interval ||
+        events > app_record_data.interval_events)
+    {
+        app_record_interval(endTime, events);
+    }
+
+    app_simulator_get_backlog(app_record_data.sim, endTime, app_record_data.backlog);
+    for (int i = 0; i < app_simulator_node_count(app_record_data.sim); i++)
+    {
+        app_simulator_get_node_results(app_record_data.sim, i, &results);
+        results_file_value_U row[] = {
+            { .i = app_record_data.run }, { .i = i },
+            { .d = results.transmitted_packets }, { .d = results.successfully_transmitted_packets },
+            { .d = results.dropped_packets }, { .d = results.collisions },
+            { .i = app_record_data.backlog[i] },
+        };
+        app_record_data.ok = results_file_append_row(app_record_data.nodes, row) && app_record_data.ok;
+    }
+
+    const app_record_config_S* config = &app_record_data.config;
+    app_simulator_get_results(app_record_data.sim, &results);
+    results_file_value_U row[] = {
+        { .i = app_record_data.run }, { .i = config->seed },
+        { .d = config->simulationTimeSec }, { .d = config->A }, { .d = config->L }, { .d = config->R },
+        { .d = config->N }, { .d = config->D }, { .d = config->S },
+        { .d = endTime }, { .i = events },
+        { .d = results.transmitted_packets }, { .d = results.successfully_transmitted_packets },
+        { .d = results.dropped_packets }, { .d = results.collisions },
+        { .d = (end.tv_sec - app_record_data.start.tv_sec) + (end.tv_nsec - app_record_data.start.tv_nsec)*1e-9 },
+    };
+    app_record_data.ok = results_file_append_row(app_record_data.summary, row) && app_record_data.ok;
+
+    // Summary last, a reader that finds a run's summary row finds the rest of it too
+    app_record_data.ok = results_file_close_writer(app_record_data.intervals) && app_record_data.ok;
+    app_record_data.ok = results_file_close_writer(app_record_data.nodes) && app_record_data.ok;
+    app_record_data.ok = results_file_close_writer(app_record_data.summary) && app_record_data.ok;
+    app_record_data.intervals = NULL;
+    app_record_data.nodes = NULL;
+    app_record_data.summary = NULL;
+    free(app_record_data.backlog);
+    app_record_data.backlog = NULL;
+
+    if (!app_record_data.ok)
+    {
+        fprintf(stderr, "Cannot write results file %s\r\n", config->path);
+    }
+    return app_record_data.ok;
+}
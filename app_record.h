@@ -0,0 +1,75 @@
+/**
+ *  @file   app_record.h
+ *  @brief  API for the columnar record of a single run
+ *
+ *  A run appends to three results files: one summary row to the file it is given, one row per
+ *  node to <file>.nodes and one row per interval of sim time to <file>.intervals. Every row
+ *  starts with the run id, the wall clock start time in nanoseconds, so runs appended to the
+ *  same files can be told apart and joined.
+ */
+
+#ifndef APP_RECORD_H
+#define APP_RECORD_H
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_simulator.h"
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define APP_RECORD_DEFAULT_INTERVALS (100)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef struct
+{
+    const char*  path;
+    double       simulationTimeSec;
+    double       A;
+    double       L;
+    double       R;
+    double       N;
+    double       D;
+    double       S;
+    unsigned int seed;
+    double       interval;      // Sim seconds per interval row
+} app_record_config_S;
+
+/*************************************************************************
+ *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ *  @brief  Open the results files and start recording a run
+ *  @param  sim Instance to record, it must outlive the record
+ *  @return False if a results file could not be opened or has a different schema
+ */
+bool app_record_init(const app_record_config_S* config, const app_simulator_data_S* sim);
+
+/**
+ *  @brief  Note an event. Cheap unless the event ends an interval, then the interval's row is
+ *          added. The row holds the events up to and including this one
+ *  @param  time Time the event returned, negative ones are ignored
+ *  @param  events Events run so far
+ */
+void app_record_event(double time, uint64_t events);
+
+/**
+ *  @brief  Add the last interval, the per-node rows and the summary row, then close the files
+ *  @param  endTime Time of the last event, the run ends there rather than at simulationTimeSec
+ *          once a node runs out of arrivals
+ *  @param  events Events run in all
+ *  @return False if anything could not be written
+ */
+bool app_record_finish(double endTime, uint64_t events);
+
+#endif /* APP_RECORD_H */
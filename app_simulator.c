@@ -9,6 +9,8 @@
 
 #include "app_simulator.h"
 #include "timestamp_generator.h"
+#include "arrival_cache.h"
+#include "telemetry.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -21,6 +23,7 @@
 
 #define APP_SIMULATOR_PROGRESS           (0U)
 #define APP_SIMULATOR_QUEUE_DEFAULT_SIZE (1000000000)
+#define APP_SIMULATOR_UNROLL             _Pragma("GCC unroll 32")
 
 /*************************************************************************
  *                            T Y P E D E S                              *
@@ -32,7 +35,9 @@ typedef enum
     APP_SIMULATOR_NODE
 } app_simulator_queueType_E;
 
-typedef struct
+typedef double (*app_simulator_kernel_F)(app_simulator_data_S* sim);
+
+struct app_simulator_data_S
 {
     // SIM PARAMETERS
     double      simulationTimeSecs;
@@ -44,19 +49,28 @@ typedef struct
     double      S;
 
     // NODES
+    const arrival_cache_entry_S* arrivals;  // Station nodes are views of these
     Queue** nodes;
+    double* node_heads;
+    app_simulator_results_S* node_results;  // Each node's share of the metrics below
     Queue* shared_bus;
     
 
     // METRICS
     double      transmitted_packets;
     double      successfully_transmitted_packets;
+    double      dropped_packets;
+    double      collisions;
 
     // HELPERS
     double      T_prop;
     double      T_trans;
     int         shared_bus_sending_node;
-} app_simulator_data_S;
+    app_simulator_kernel_F kernel;
+    timestamp_rng_S rng;
+    app_simulator_txCallback_F tx_callback;
+    void*       tx_ctx;
+};
 
 
 /*************************************************************************
@@ -64,14 +78,30 @@ typedef struct
  *************************************************************************/
 
 /**
- * @brief Persistent carrier sensing
+ * @brief Persistent carrier sensing, generic kernel for any N
+ */
+static double app_simulator_persistent_sensing(app_simulator_data_S* sim);
+
+/**
+ * @brief Pick the sensing kernel specialized for N, or the generic one
+ */
+static app_simulator_kernel_F app_simulator_select_kernel(int N);
+
+/**
+ * @brief Set up a simulator instance and pre-fill its nodes with arrivals
+ * @return False if there is no memory for it, what was set up is left for teardown
+ */
+static bool app_simulator_setup(app_simulator_data_S* sim, double simulationTimeSec, double A, double L, double R, double N, double D, double S, unsigned int seed);
+
+/**
+ * @brief Free everything a simulator instance owns
  */
-static double app_simulator_persistent_sensing(void);
+static void app_simulator_teardown(app_simulator_data_S* sim);
 
 /**
  * @brief Perform operations on a node when collision is detected
  */
-static void app_simulator_collision_detected(Queue* node);
+static void app_simulator_collision_detected(app_simulator_data_S* sim, int index);
 
 /**
  * @brief Check to see if current node head is scheduled to arrive before bus send is over. If so, update node values
@@ -89,26 +119,32 @@ app_simulator_data_S app_simulator_data;
  *************************************************************************/
 
 // Works on a per node basis
-static void app_simulator_collision_detected(Queue* node)
+static void app_simulator_collision_detected(app_simulator_data_S* sim, int index)
 {
+    Queue* node = sim->nodes[index];
+    app_simulator_results_S* node_results = &sim->node_results[index];
     int returnCount = 0;
     // Increment the Queue collision counter
     Queue_Increment_Collision(node);
+    sim->collisions++;
+    node_results->collisions++;
 
     // Choose a random var
-    int K_pick = return_random(Queue_Collision_Count(node));
+    int K_pick = return_random_r(&sim->rng, Queue_Collision_Count(node));
 
     if(K_pick > 10)
     {
         Queue_Dequeue(node);
         Queue_Reset_Collision(node);
+        sim->dropped_packets++;
+        node_results->dropped_packets++;
     }
 
     else
     {
         // Calculate exponential backoff time and update all Queue values to correspond to this
         double wait_time = (double)K_pick*512.0 + Queue_PeekHead(node);
-        if (wait_time >= app_simulator_data.simulationTimeSecs)
+        if (wait_time >= sim->simulationTimeSecs)
 	{
 	    Queue_Dequeue(node);
             Queue_Reset_Collision(node);
@@ -118,7 +154,8 @@ static void app_simulator_collision_detected(Queue* node)
 	else
 	{
 		 returnCount = Queue_update_times(node, wait_time);
-		 app_simulator_data.transmitted_packets += returnCount;
+		 sim->transmitted_packets += returnCount;
+		 node_results->transmitted_packets += returnCount;
 	}
     }
 
@@ -135,88 +172,119 @@ static void app_simulator_bus_busy(Queue* node, double localSendTime)
     }
 }
 
-static double app_simulator_persistent_sensing(void)
+// Shared body of every sensing kernel. Always inlined so that each caller with a
+// constant N gets its own fully unrolled copy with fixed-size scratch arrays.
+// Node heads are read from the node_heads mirror rather than the queues themselves, the queue
+// arrays are all allocated alike so their heads alias in cache once N gets large
+static inline __attribute__((always_inline)) double app_simulator_persistent_sensing_body(app_simulator_data_S* sim, const int N, double* min_heads, int* min_nodes, bool* collides)
 {
-    int i, minTimeNode, isCollisionDetected = 0;
+    int i, width, minTimeNode = 0, isCollisionDetected = 0;
     double minTimeStamp = DBL_MAX;
-    double maxSendTime = 0, localSendTime = 0, ret = 0;
-    double node_heads[app_simulator_data.N];
+    double localSendTime = 0, ret = 0;
+    Queue** nodes = sim->nodes;
+    double* node_heads = sim->node_heads;
 
     // Check to see if bus is occupied. If occupied, Update the other node times to accomodate
-    if(app_simulator_data.shared_bus->size != 0)
+    if(sim->shared_bus->size != 0)
     {
-        for (i = 0; i < app_simulator_data.N; i++)
+        APP_SIMULATOR_UNROLL
+        for (i = 0; i < N; i++)
         {
             // Skip if current node transmitting
-            if(i == app_simulator_data.shared_bus_sending_node)
+            if(i == sim->shared_bus_sending_node)
             {
                 continue;
             }
 
        	    // Calculate time to send to each node and them update the queues if needed
-            localSendTime = app_simulator_data.T_trans + (app_simulator_data.T_prop * abs(app_simulator_data.shared_bus_sending_node-i));
-            if (localSendTime > app_simulator_data.simulationTimeSecs) 
+            localSendTime = sim->T_trans + (sim->T_prop * abs(sim->shared_bus_sending_node-i));
+            if (localSendTime > sim->simulationTimeSecs) 
             {
                 continue;
             }
-            app_simulator_bus_busy(app_simulator_data.nodes[i], localSendTime);
+            if (node_heads[i] < localSendTime)
+            {
+                app_simulator_bus_busy(nodes[i], localSendTime);
+                node_heads[i] = Queue_PeekHead(nodes[i]);
+            }
         }
 
         // Dequeue current packet from shared bus.
-        ret = Queue_Dequeue(app_simulator_data.shared_bus);
+        ret = Queue_Dequeue(sim->shared_bus);
         return ret;
     }
     
     else {
 
         // Bus is empty. Can send packet
-        for (i = 0; i < app_simulator_data.N; i++)
+        // Check for lowest timestamp with a pairwise tournament instead of one long compare chain,
+        // a tie keeps the left (lower index) node just like a strict compare in node order would
+        // TODO: Confirm lowest timestamp against waiting value for exponential backoff
+        min_heads[0] = DBL_MAX;
+        min_nodes[0] = 0;
+        APP_SIMULATOR_UNROLL
+        for (i = 0; i < N; i++)
         {
-            // Check for lowest timestamp
-            // TODO: Confirm lowest timestamp against waiting value for exponential backoff
-            node_heads[i] = Queue_PeekHead(app_simulator_data.nodes[i]);
-            if (node_heads[i] < minTimeStamp)
+            min_heads[i] = node_heads[i];
+            min_nodes[i] = i;
+        }
+        APP_SIMULATOR_UNROLL
+        for (width = 1; width < N; width *= 2)
+        {
+            APP_SIMULATOR_UNROLL
+            for (i = 0; i + width < N; i += 2*width)
             {
-                minTimeStamp = node_heads[i];
-                minTimeNode = i;
+                bool isLower = min_heads[i + width] < min_heads[i];
+                min_heads[i] = isLower ? min_heads[i + width] : min_heads[i];
+                min_nodes[i] += isLower*(min_nodes[i + width] - min_nodes[i]);
             }
-
         }
+        minTimeStamp = min_heads[0];
+        minTimeNode = min_nodes[0];
 
         if (minTimeStamp == -1)
         {
             return -1;
         }
 
-        // Scan through heads of all the nodes to determine which nodes will experience a collision
-        for (i = 0; i < app_simulator_data.N; i++)
+        // Scan through heads of all the nodes to determine which nodes will experience a collision.
+        // The node with the lowest timestep aka the node we're checking against is never marked
+        APP_SIMULATOR_UNROLL
+        for (i = 0; i < N; i++)
         {
-            // Skip the node with the lowest timestep aka the node we're checking against for collisions
-            if (i == minTimeNode)
-            {
-                continue;
-            }
-
             // Check how long it will take for first bit of current packet to reach selected node 
-            localSendTime = minTimeStamp + (app_simulator_data.T_prop*(abs(minTimeNode - i)));
+            localSendTime = minTimeStamp + (sim->T_prop*(abs(minTimeNode - i)));
+            collides[i] = (node_heads[i] < localSendTime) & (i != minTimeNode);
+        }
 
-            if (node_heads[i] < localSendTime)
+        // Handle collisions in node order, this consumes random numbers so the order matters
+        APP_SIMULATOR_UNROLL
+        for (i = 0; i < N; i++)
+        {
+            if (collides[i])
             {
                 isCollisionDetected = 0;
-                app_simulator_collision_detected(app_simulator_data.nodes[i]);
+                app_simulator_collision_detected(sim, i);
+                node_heads[i] = Queue_PeekHead(nodes[i]);
                 ret = minTimeStamp;
             }
-
         }
 
         if (!isCollisionDetected)
         {
             // Dequeue packet
             do{
-                localSendTime = Queue_Dequeue(app_simulator_data.nodes[minTimeNode]);
-                app_simulator_data.transmitted_packets++;
-                app_simulator_data.successfully_transmitted_packets++;
-            } while(Queue_PeekHead(app_simulator_data.nodes[minTimeNode]) == localSendTime);
+                localSendTime = Queue_Dequeue(nodes[minTimeNode]);
+                sim->transmitted_packets++;
+                sim->successfully_transmitted_packets++;
+                sim->node_results[minTimeNode].transmitted_packets++;
+                sim->node_results[minTimeNode].successfully_transmitted_packets++;
+                if (sim->tx_callback != NULL && localSendTime != -1)
+                {
+                    sim->tx_callback(sim->tx_ctx, minTimeNode, localSendTime);
+                }
+            } while(Queue_PeekHead(nodes[minTimeNode]) == localSendTime);
+            node_heads[minTimeNode] = Queue_PeekHead(nodes[minTimeNode]);
             // next packet arrival time is less than current arrival time but if thats happening then I have a whole other butthole issue
             
             if (localSendTime == -1)
@@ -225,8 +293,8 @@ static double app_simulator_persistent_sensing(void)
             }
 
             // Enqueue packet onto shared bus and set the shared bus node to the transmitting node
-            Queue_Enqueue(app_simulator_data.shared_bus, localSendTime);
-            app_simulator_data.shared_bus_sending_node = minTimeNode;
+            Queue_Enqueue(sim->shared_bus, localSendTime);
+            sim->shared_bus_sending_node = minTimeNode;
             ret = minTimeStamp;
 
         }
@@ -235,93 +303,166 @@ static double app_simulator_persistent_sensing(void)
     
 }
 
+// Generic kernel, any N
+static double app_simulator_persistent_sensing(app_simulator_data_S* sim)
+{
+    double min_heads[sim->N];
+    int min_nodes[sim->N];
+    bool collides[sim->N];
+
+    return app_simulator_persistent_sensing_body(sim, sim->N, min_heads, min_nodes, collides);
+}
+
+// Pre-instantiated kernels for the node counts we run day to day
+#define APP_SIMULATOR_SENSING_KERNEL(n)                                        \
+static double app_simulator_persistent_sensing_N##n(app_simulator_data_S* sim) \
+{                                                                              \
+    double min_heads[n];                                                       \
+    int min_nodes[n];                                                          \
+    bool collides[n];                                                          \
+                                                                               \
+    return app_simulator_persistent_sensing_body(sim, n, min_heads, min_nodes, \
+                                                 collides);                    \
+}
+
+APP_SIMULATOR_SENSING_KERNEL(4)
+APP_SIMULATOR_SENSING_KERNEL(8)
+APP_SIMULATOR_SENSING_KERNEL(16)
+APP_SIMULATOR_SENSING_KERNEL(20)
+APP_SIMULATOR_SENSING_KERNEL(32)
+
+static app_simulator_kernel_F app_simulator_select_kernel(int N)
+{
+    switch (N)
+    {
+        case 4:  return app_simulator_persistent_sensing_N4;
+        case 8:  return app_simulator_persistent_sensing_N8;
+        case 16: return app_simulator_persistent_sensing_N16;
+        case 20: return app_simulator_persistent_sensing_N20;
+        case 32: return app_simulator_persistent_sensing_N32;
+        default: return app_simulator_persistent_sensing;
+    }
+}
 
-/*************************************************************************
- *                    P U B L I C   F U N C T I O N S                    *
- *************************************************************************/
 
-void app_simulator_init(double simulationTimeSec, double A, double L, double R, double N, double D, double S)
+static bool app_simulator_setup(app_simulator_data_S* sim, double simulationTimeSec, double A, double L, double R, double N, double D, double S, unsigned int seed)
 {
-    memset(&app_simulator_data, 0, sizeof(app_simulator_data));
+    memset(sim, 0, sizeof(*sim));
 
     //Store passed in sim variables
-    app_simulator_data.simulationTimeSecs = simulationTimeSec;
-    app_simulator_data.A = A;
-    app_simulator_data.L = L;
-    app_simulator_data.R = R;
-    app_simulator_data.N = N;
-    app_simulator_data.D = D;
-    app_simulator_data.S = S;
-    app_simulator_data.T_prop = D/S;
-    app_simulator_data.T_trans = L/R;
-    app_simulator_data.nodes = malloc(N*sizeof(Queue*));
-    app_simulator_data.shared_bus = Queue_Init(1, -1);
+    sim->simulationTimeSecs = simulationTimeSec;
+    sim->A = A;
+    sim->L = L;
+    sim->R = R;
+    sim->N = N;
+    sim->D = D;
+    sim->S = S;
+    sim->T_prop = D/S;
+    sim->T_trans = L/R;
+    sim->nodes = calloc(N, sizeof(Queue*));
+    sim->node_heads = malloc(N*sizeof(double));
+    sim->node_results = calloc(N, sizeof(app_simulator_results_S));
+    sim->shared_bus = Queue_Init(1, -1);
+    sim->kernel = app_simulator_select_kernel(sim->N);
+    if (sim->nodes == NULL || sim->node_heads == NULL || sim->node_results == NULL || sim->shared_bus == NULL)
+    {
+        return false;
+    }
+
+    // Arrivals only depend on simTime, A, N and the seed, runs that share those share one read-only copy.
+    // Collisions keep drawing from the random number stream where generating the arrivals left it
+    sim->arrivals = arrival_cache_acquire(simulationTimeSec, A, sim->N, seed, APP_SIMULATOR_QUEUE_DEFAULT_SIZE);
+    if (sim->arrivals == NULL)
+    {
+        return false;
+    }
+    arrival_cache_get_rng(sim->arrivals, &sim->rng);
 
 
     // Calculate lambda
-    // app_simulator_data.lambda = ((double)rho*C)/((double)L);
-    // printf("rho: %f\r\n", app_simulator_data.rho);
+    // sim->lambda = ((double)rho*C)/((double)L);
+    // printf("rho: %f\r\n", sim->rho);
 
 
     // Populate nodes
-    double currentTime = 0;
     for(int i = 0; i < N; i++)
     {
-        //node_ptr = malloc(app_simulator_data.N = N, sizeof(Queue *));
-        Queue* node_ptr = Queue_Init(APP_SIMULATOR_QUEUE_DEFAULT_SIZE, i);
-        currentTime = 0;
-	 do
+        Queue* node_ptr = Queue_View(arrival_cache_values(sim->arrivals, i), arrival_cache_count(sim->arrivals, i), i);
+        if (node_ptr == NULL)
         {
-            // Generate random timestamps
-            currentTime = timestamp_generate(app_simulator_data.A, currentTime);
-
-            if (currentTime >= app_simulator_data.simulationTimeSecs) // Check this condition. It might mess things up in the logic.
-            // Maybe should check nodes for this value? not sure
-            {
-                currentTime = -1;
-            }
-
-            // Add 
-            Queue_Enqueue(node_ptr, currentTime);
-
-            if (currentTime == -1)
-            {
-                break;
-            }
-        } while (Queue_IsFull(node_ptr) != true);
+            return false;
+        }
 
-        app_simulator_data.nodes[i] = node_ptr;
+        sim->nodes[i] = node_ptr;
+        sim->node_heads[i] = Queue_PeekHead(node_ptr);
     } 
 
     /*
     // Make sure we didn't run out of space filling up the event queues
-    if ((Queue_PeekTail(app_simulator_data.observerEvents) != -1) ||
-        Queue_PeekTail(app_simulator_data.arrivalEvents) != -1)
+    if ((Queue_PeekTail(sim->observerEvents) != -1) ||
+        Queue_PeekTail(sim->arrivalEvents) != -1)
     {
         printf("ERROR: Queue overflow\r\n");
-        printf("ObserverQueueTail: %f\r\n", Queue_PeekHead(app_simulator_data.observerEvents));
-        printf("ArrivalQueueTail: %f\r\n", Queue_PeekHead(app_simulator_data.arrivalEvents));
+        printf("ObserverQueueTail: %f\r\n", Queue_PeekHead(sim->observerEvents));
+        printf("ArrivalQueueTail: %f\r\n", Queue_PeekHead(sim->arrivalEvents));
     }
     */
+
+    return true;
 }
 
+static void app_simulator_teardown(app_simulator_data_S* sim)
+{
+    for (int i = 0; sim->nodes != NULL && i < sim->N; i++)
+    {
+        Queue_Delete(sim->nodes[i]);
+        sim->nodes[i] = NULL;
+    }
+    free(sim->nodes);
+    sim->nodes = NULL;
+    free(sim->node_heads);
+    sim->node_heads = NULL;
+    free(sim->node_results);
+    sim->node_results = NULL;
+    Queue_Delete(sim->shared_bus);
+    sim->shared_bus = NULL;
+    arrival_cache_release(sim->arrivals);
+    sim->arrivals = NULL;
+}
 
 
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+bool app_simulator_init(double simulationTimeSec, double A, double L, double R, double N, double D, double S)
+{
+    if (!app_simulator_setup(&app_simulator_data, simulationTimeSec, A, L, R, N, D, S, APP_SIMULATOR_DEFAULT_SEED))
+    {
+        app_simulator_teardown(&app_simulator_data);
+        return false;
+    }
+    return true;
+}
+
+
+
+
+app_simulator_data_S* app_simulator_default(void)
+{
+    return &app_simulator_data;
+}
 
 double app_simulator_run(void)
 {
 
-    return app_simulator_persistent_sensing();
+    return app_simulator_step(&app_simulator_data);
     
 }
 
 void app_simulator_deinit(void)
 {
-    for (int i = 0; i < app_simulator_data.N; i++)
-    {
-        Queue_Delete(app_simulator_data.nodes[i]);
-        app_simulator_data.nodes[i] = NULL;
-    }
+    app_simulator_teardown(&app_simulator_data);
 }
 
 void app_simulator_print_results(void)
@@ -331,4 +472,162 @@ void app_simulator_print_results(void)
 
 }
 
+void app_simulator_publish_telemetry(double time, uint64_t events)
+{
+    int64_t backlog[app_simulator_data.N];
+    telemetry_sample_S sample = {
+        .events = events,
+        .sim_time = time,
+        .transmitted_packets = app_simulator_data.transmitted_packets,
+        .successfully_transmitted_packets = app_simulator_data.successfully_transmitted_packets,
+        .dropped_packets = app_simulator_data.dropped_packets,
+        .collisions = app_simulator_data.collisions,
+    };
+
+    app_simulator_get_backlog(&app_simulator_data, time, backlog);
+    telemetry_publish(&sample, backlog);
+}
+
+app_simulator_data_S* app_simulator_create(double simulationTimeSec, double A, double L, double R, double N, double D, double S, unsigned int seed)
+{
+    app_simulator_data_S* sim = malloc(sizeof(app_simulator_data_S));
+
+    if (sim != NULL && !app_simulator_setup(sim, simulationTimeSec, A, L, R, N, D, S, seed))
+    {
+        app_simulator_destroy(sim);
+        return NULL;
+    }
+
+    return sim;
+}
+
+void app_simulator_destroy(app_simulator_data_S* sim)
+{
+    if (sim == NULL)
+    {
+        return;
+    }
+
+    app_simulator_teardown(sim);
+    free(sim);
+}
+
+double app_simulator_step(app_simulator_data_S* sim)
+{
+    return sim->kernel(sim);
+}
+
+double app_simulator_next_time(const app_simulator_data_S* sim)
+{
+    double minTimeStamp = DBL_MAX;
+
+    // A packet on the bus is dequeued before any node is looked at
+    if (sim->shared_bus->size != 0)
+    {
+        return Queue_PeekHead(sim->shared_bus);
+    }
+
+    for (int i = 0; i < sim->N; i++)
+    {
+        if (sim->node_heads[i] < minTimeStamp)
+        {
+            minTimeStamp = sim->node_heads[i];
+        }
+    }
+
+    return minTimeStamp;
+}
+
+int app_simulator_add_port(app_simulator_data_S* sim, int64_t capacity, bool first)
+{
+    int port = first ? 0 : sim->N;
+    Queue* node_ptr = Queue_Init(capacity, port);
+    // Arrays that did grow stay grown if a later one fails, they are only ever indexed up to N
+    Queue** nodes = realloc(sim->nodes, (sim->N + 1)*sizeof(Queue*));
+    sim->nodes = (nodes != NULL) ? nodes : sim->nodes;
+    double* node_heads = realloc(sim->node_heads, (sim->N + 1)*sizeof(double));
+    sim->node_heads = (node_heads != NULL) ? node_heads : sim->node_heads;
+    app_simulator_results_S* node_results = realloc(sim->node_results, (sim->N + 1)*sizeof(app_simulator_results_S));
+    sim->node_results = (node_results != NULL) ? node_results : sim->node_results;
+
+    if (node_ptr == NULL || nodes == NULL || node_heads == NULL || node_results == NULL)
+    {
+        Queue_Delete(node_ptr);
+        return -1;
+    }
+
+    // An empty port peeks as DBL_MAX so it never wins the bus or sees a collision
+    node_ptr->arr[node_ptr->tail] = DBL_MAX;
+
+    // Bus distance is the difference in node index, a port in front sits at the near end
+    if (first)
+    {
+        memmove(&sim->nodes[1], &sim->nodes[0], sim->N*sizeof(Queue*));
+        memmove(&sim->node_heads[1], &sim->node_heads[0], sim->N*sizeof(double));
+        memmove(&sim->node_results[1], &sim->node_results[0], sim->N*sizeof(app_simulator_results_S));
+        sim->shared_bus_sending_node++;
+    }
+    sim->nodes[port] = node_ptr;
+    sim->node_heads[port] = DBL_MAX;
+    memset(&sim->node_results[port], 0, sizeof(app_simulator_results_S));
+    sim->N++;
+    sim->kernel = app_simulator_select_kernel(sim->N);
+
+    return port;
+}
+
+bool app_simulator_port_enqueue(app_simulator_data_S* sim, int port, double time)
+{
+    Queue* node_ptr = sim->nodes[port];
 
+    // Keep one slot free for the DBL_MAX end marker
+    if (node_ptr->size + 1 >= node_ptr->capacity)
+    {
+        return false;
+    }
+
+    // A packet arriving while the port backs off waits behind the head, same as Queue_update_times
+    // would have done had it been queued already
+    if (!Queue_IsEmpty(node_ptr) && time < Queue_Get(node_ptr, node_ptr->size - 1))
+    {
+        time = Queue_Get(node_ptr, node_ptr->size - 1);
+    }
+
+    Queue_Enqueue(node_ptr, time);
+    node_ptr->arr[node_ptr->tail] = DBL_MAX;
+    sim->node_heads[port] = Queue_PeekHead(node_ptr);
+
+    return true;
+}
+
+void app_simulator_set_tx_callback(app_simulator_data_S* sim, app_simulator_txCallback_F callback, void* ctx)
+{
+    sim->tx_callback = callback;
+    sim->tx_ctx = ctx;
+}
+
+void app_simulator_get_results(const app_simulator_data_S* sim, app_simulator_results_S* results)
+{
+    results->transmitted_packets = sim->transmitted_packets;
+    results->successfully_transmitted_packets = sim->successfully_transmitted_packets;
+    results->dropped_packets = sim->dropped_packets;
+    results->collisions = sim->collisions;
+}
+
+int app_simulator_node_count(const app_simulator_data_S* sim)
+{
+    return sim->N;
+}
+
+void app_simulator_get_node_results(const app_simulator_data_S* sim, int node, app_simulator_results_S* results)
+{
+    *results = sim->node_results[node];
+}
+
+void app_simulator_get_backlog(const app_simulator_data_S* sim, double time, int64_t* backlog)
+{
+    for (int i = 0; i < sim->N; i++)
+    {
+        backlog[i] = Queue_Count_Arrived(sim->nodes[i], time);
+    }
+}
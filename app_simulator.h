@@ -17,6 +17,8 @@
  *                            D E F I N E S                              *
  *************************************************************************/
 
+#define APP_SIMULATOR_DEFAULT_SEED (1U)
+
 /*************************************************************************
  *                            T Y P E D E S                              *
  *************************************************************************/
@@ -27,14 +29,36 @@ typedef enum
     APP_SIMULATOR_RET_SIM_COMPLETE,
 } app_simulator_retCode_E;
 
+/**
+ *  @brief  Simulator instance. The init/run/deinit API works on a built-in default instance
+ */
+typedef struct app_simulator_data_S app_simulator_data_S;
+
+typedef struct
+{
+    double transmitted_packets;
+    double successfully_transmitted_packets;
+    double dropped_packets;             // Given up after too many collisions
+    double collisions;                  // Packets that collided, once per node involved
+} app_simulator_results_S;
+
+/**
+ *  @brief  Called for every packet a node successfully puts on the bus
+ *  @param  ctx Context given to app_simulator_set_tx_callback
+ *  @param  node Index of the sending node
+ *  @param  time Timestamp of the packet
+ */
+typedef void (*app_simulator_txCallback_F)(void* ctx, int node, double time);
+
 /*************************************************************************
  *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
  *************************************************************************/
 
 /**
  *  @brief  Initialize the simulator application
+ *  @return False if there is no memory for the simulation
  */
-void app_simulator_init(double simulationTimeSec, double A, double L, double R, double N, double D, double S);
+bool app_simulator_init(double simulationTimeSec, double A, double L, double R, double N, double D, double S);
 
 /**
  *  @brief  De-initialize the simulator application
@@ -49,6 +73,86 @@ double app_simulator_run(void);
 
 void app_simulator_print_results(void);
 
+/**
+ *  @brief  Default instance behind init/run/deinit, for use with the per-instance functions
+ */
+app_simulator_data_S* app_simulator_default(void);
+
+/**
+ *  @brief  Publish the default instance to the telemetry page set up with telemetry_init
+ *  @param  time Sim time of the last event
+ *  @param  events Events run so far
+ */
+void app_simulator_publish_telemetry(double time, uint64_t events);
+
+/**
+ *  @brief  Create a simulator instance with its own random number stream
+ *  @param  seed Seed for the instance, APP_SIMULATOR_DEFAULT_SEED reproduces app_simulator_init
+ *  @return Pointer to the created instance, NULL if there is no memory for it
+ */
+app_simulator_data_S* app_simulator_create(double simulationTimeSec, double A, double L, double R, double N, double D, double S, unsigned int seed);
+
+/**
+ *  @brief  Delete a simulator instance
+ */
+void app_simulator_destroy(app_simulator_data_S* sim);
+
+/**
+ *  @brief  Run one event of a simulator instance
+ *  @return Current time value, negative once the simulation is complete
+ */
+double app_simulator_step(app_simulator_data_S* sim);
+
+/**
+ *  @brief  Timestamp of the next event the instance will process
+ *  @return Next event time, -1 if the next step completes the simulation
+ */
+double app_simulator_next_time(const app_simulator_data_S* sim);
+
+/**
+ *  @brief  Add a port node at one end of the bus. A port has no generated arrivals,
+ *          packets are handed to it with app_simulator_port_enqueue
+ *  @param  capacity Most packets the port holds at once
+ *  @param  first Put the port in front of every node so far, which moves each of them up one
+ *          index, rather than behind them
+ *  @return Node index of the port, -1 if there is no memory for it
+ */
+int app_simulator_add_port(app_simulator_data_S* sim, int64_t capacity, bool first);
+
+/**
+ *  @brief  Queue a packet arrival on a port node. Arrivals must come in time order
+ *  @param  port Node index returned by app_simulator_add_port
+ *  @param  time Arrival time of the packet
+ *  @return False if the port is full and the packet was dropped
+ */
+bool app_simulator_port_enqueue(app_simulator_data_S* sim, int port, double time);
+
+/**
+ *  @brief  Register a callback for successful transmissions, NULL to remove it
+ */
+void app_simulator_set_tx_callback(app_simulator_data_S* sim, app_simulator_txCallback_F callback, void* ctx);
+
+/**
+ *  @brief  Copy out the metrics of a simulator instance
+ */
+void app_simulator_get_results(const app_simulator_data_S* sim, app_simulator_results_S* results);
+
+/**
+ *  @brief  Number of nodes, ports included
+ */
+int app_simulator_node_count(const app_simulator_data_S* sim);
+
+/**
+ *  @brief  Copy out one node's share of the metrics, they add up to app_simulator_get_results
+ */
+void app_simulator_get_node_results(const app_simulator_data_S* sim, int node, app_simulator_results_S* results);
+
+/**
+ *  @brief  Packets per node that have arrived by a sim time but not been sent or dropped yet
+ *  @param  backlog Room for one count per node
+ */
+void app_simulator_get_backlog(const app_simulator_data_S* sim, double time, int64_t* backlog);
+
 // /**
 //  *  @brief  Output the results of the simulation
 //  */
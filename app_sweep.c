@@ -0,0 +1,803 @@
+/**
+ *  @file   app_sweep.c
+ *  @brief  Multi-process sweep coordinator and worker
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "app_sweep.h"
+#include "app_simulator.h"
+#include "results_file.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define APP_SWEEP_LINE_SIZE  (512)
+#define APP_SWEEP_EXIT_GRACE (5.0)
+#define APP_SWEEP_REAP_POLL  (10000)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef enum
+{
+    APP_SWEEP_UNIT_PENDING,
+    APP_SWEEP_UNIT_RUNNING,
+    APP_SWEEP_UNIT_DONE,
+    APP_SWEEP_UNIT_FAILED,
+} app_sweep_unitState_E;
+
+typedef struct
+{
+    // PARAMETERS
+    double       simulationTimeSec;
+    double       A;
+    double       L;
+    double       R;
+    double       N;
+    double       D;
+    double       S;
+    unsigned int seed;
+
+    // RESULTS
+    app_sweep_unitState_E state;
+    int          attempts;
+    double       transmitted_packets;
+    double       successfully_transmitted_packets;
+    double       dropped_packets;
+    double       collisions;
+    double       wall_secs;
+} app_sweep_unit_S;
+
+typedef struct
+{
+    pid_t  pid;
+    int    fd;      // -1 once the worker is gone
+    int    unit;    // Unit being run, -1 when none
+    double deadline; // Time the unit must be back by, on app_sweep_now's clock
+    double exit_by;  // Time the process is killed by once told to quit, 0 until then
+    bool   idle;    // Asked for a unit, by READY or by returning one
+    bool   started; // Sent READY at least once
+    char   line[APP_SWEEP_LINE_SIZE];
+    size_t len;
+} app_sweep_worker_S;
+
+typedef struct
+{
+    pid_t  pid;
+    double kill_by; // Time the process is killed by if it has not exited
+    bool   killed;
+} app_sweep_exiting_S;
+
+typedef struct
+{
+    app_sweep_config_S  config;
+    app_sweep_unit_S*   units;
+    int                 unit_count;
+    int                 remaining;    // Units neither done nor failed
+    int                 dead_starts;  // Workers in a row that died before sending READY
+    int                 next_unit;    // First unit never sent out
+    int*                retry;        // Units sent back for another attempt, in the order they came
+    int                 retry_head;
+    int                 retry_count;
+    app_sweep_worker_S* workers;
+    app_sweep_exiting_S* exiting; // Retired worker processes not reaped yet
+    int                 exiting_count;
+    int                 exiting_capacity;
+} app_sweep_data_S;
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Start a worker process connected over a socket pair
+ * @return False if the worker could not be started
+ */
+static bool app_sweep_spawn(app_sweep_worker_S* worker);
+
+/**
+ * @brief Close a worker and put its unit back in line. The process is signalled and left to
+ *        app_sweep_reap rather than waited for
+ */
+static void app_sweep_retire(app_sweep_worker_S* worker);
+
+/**
+ * @brief Reap retired worker processes that have exited, kill ones past their grace period
+ */
+static void app_sweep_reap(void);
+
+/**
+ * @brief Record a failed attempt at a unit, back to pending while attempts remain
+ */
+static void app_sweep_unit_failed(int unit);
+
+/**
+ * @brief Give an idle worker the next pending unit, if there is one
+ */
+static void app_sweep_dispatch(app_sweep_worker_S* worker);
+
+/**
+ * @brief Handle one line received from a worker
+ */
+static void app_sweep_handle_line(app_sweep_worker_S* worker, const char* line);
+
+/**
+ * @brief Write the merged results as text, one line per unit
+ */
+static bool app_sweep_write_text(const char* path);
+
+/**
+ * @brief Append the merged results to a columnar results file
+ */
+static bool app_sweep_write_columnar(const char* path);
+
+/**
+ * @brief Seconds on a monotonic clock
+ */
+static double app_sweep_now(void);
+
+/**
+ * @brief Kill workers that are past the deadline of their unit
+ * @return Milliseconds until the next deadline, -1 if there is none
+ */
+static int app_sweep_check_deadlines(void);
+
+/**
+ * @brief Write a whole string to a descriptor
+ */
+static bool app_sweep_write_line(int fd, const char* line);
+
+/*************************************************************************
+ *            P R I V A T E   D A T A   D E C L A R A T I O N S          *
+ *************************************************************************/
+
+static app_sweep_data_S app_sweep_data;
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static bool app_sweep_write_line(int fd, const char* line)
+{
+    size_t len = strlen(line);
+
+    while (len > 0)
+    {
+        ssize_t written = write(fd, line, len);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        line += written;
+        len -= written;
+    }
+    return true;
+}
+
+static double app_sweep_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+static int app_sweep_check_deadlines(void)
+{
+    double now = app_sweep_now();
+    double next = -1;
+
+    if (app_sweep_data.config.unitTimeout <= 0)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < app_sweep_data.config.workers; i++)
+    {
+        app_sweep_worker_S* worker = &app_sweep_data.workers[i];
+        if (worker->fd < 0 || worker->unit < 0)
+        {
+            continue;
+        }
+
+        if (now >= worker->deadline)
+        {
+            // A hung worker may never read QUIT or close its end, so don't wait on it
+            fprintf(stderr, "Unit %d timed out on worker %d\r\n", worker->unit, (int)worker->pid);
+            kill(worker->pid, SIGKILL);
+            app_sweep_retire(worker);
+        }
+        else if (next < 0 || worker->deadline - now < next)
+        {
+            next = worker->deadline - now;
+        }
+    }
+
+    // Round up so the next check lands past the deadline rather than just short of it
+    return (next < 0) ? -1 : (int)(next*1000) + 1;
+}
+
+static bool app_sweep_spawn(app_sweep_worker_S* worker)
+{
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        // Don't hold on to the other workers' sockets, they would never see EOF
+        for (int i = 0; i < app_sweep_data.config.workers; i++)
+        {
+            if (app_sweep_data.workers[i].fd >= 0)
+            {
+                close(app_sweep_data.workers[i].fd);
+            }
+        }
+
+        if (app_sweep_data.config.workerCommand != NULL)
+        {
+            dup2(fds[1], STDIN_FILENO);
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[1]);
+            execl("/bin/sh", "sh", "-c", app_sweep_data.config.workerCommand, (char*)NULL);
+            _exit(127);
+        }
+
+        app_sweep_worker(fds[1], fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    worker->pid = pid;
+    worker->fd = fds[0];
+    worker->unit = -1;
+    worker->exit_by = 0;
+    worker->idle = false;
+    worker->started = false;
+    worker->len = 0;
+    return true;
+}
+
+static void app_sweep_unit_failed(int unit)
+{
+    app_sweep_unit_S* u = &app_sweep_data.units[unit];
+
+    if (u->attempts > app_sweep_data.config.retries)
+    {
+        u->state = APP_SWEEP_UNIT_FAILED;
+        app_sweep_data.remaining--;
+        fprintf(stderr, "Unit %d failed after %d attempts\r\n", unit, u->attempts);
+    }
+    else
+    {
+        // A unit is pending at most once, so the ring never holds more than every unit
+        u->state = APP_SWEEP_UNIT_PENDING;
+        int tail = (app_sweep_data.retry_head + app_sweep_data.retry_count) % app_sweep_data.unit_count;
+        app_sweep_data.retry[tail] = unit;
+        app_sweep_data.retry_count++;
+    }
+}
+
+static void app_sweep_retire(app_sweep_worker_S* worker)
+{
+    if (worker->unit >= 0)
+    {
+        app_sweep_unit_failed(worker->unit);
+        worker->unit = -1;
+    }
+    if (!worker->started)
+    {
+        app_sweep_data.dead_starts++;
+    }
+    close(worker->fd);
+    worker->fd = -1;
+
+    // A worker told to quit gets until exit_by to do so on its own, any other is of no further
+    // use and is asked to stop now. Either is killed if still around after its grace period
+    if (worker->exit_by == 0)
+    {
+        kill(worker->pid, SIGTERM);
+    }
+    if (app_sweep_data.exiting_count == app_sweep_data.exiting_capacity)
+    {
+        int capacity = (app_sweep_data.exiting_capacity == 0) ? 16 : app_sweep_data.exiting_capacity*2;
+        app_sweep_exiting_S* exiting = realloc(app_sweep_data.exiting, capacity*sizeof(app_sweep_exiting_S));
+        if (exiting == NULL)
+        {
+            // Nowhere to track it, a killed process is reaped straight away
+            kill(worker->pid, SIGKILL);
+            waitpid(worker->pid, NULL, 0);
+            return;
+        }
+        app_sweep_data.exiting = exiting;
+        app_sweep_data.exiting_capacity = capacity;
+    }
+    app_sweep_exiting_S* exiting = &app_sweep_data.exiting[app_sweep_data.exiting_count++];
+    exiting->pid = worker->pid;
+    exiting->kill_by = (worker->exit_by > 0) ? worker->exit_by : app_sweep_now() + APP_SWEEP_EXIT_GRACE;
+    exiting->killed = false;
+}
+
+static void app_sweep_reap(void)
+{
+    double now = app_sweep_now();
+
+    for (int i = 0; i < app_sweep_data.exiting_count; )
+    {
+        app_sweep_exiting_S* exiting = &app_sweep_data.exiting[i];
+        if (waitpid(exiting->pid, NULL, WNOHANG) != 0)
+        {
+            *exiting = app_sweep_data.exiting[--app_sweep_data.exiting_count];
+            continue;
+        }
+        if (!exiting->killed && now >= exiting->kill_by)
+        {
+            kill(exiting->pid, SIGKILL);
+            exiting->killed = true;
+        }
+        i++;
+    }
+}
+
+static void app_sweep_dispatch(app_sweep_worker_S* worker)
+{
+    char line[APP_SWEEP_LINE_SIZE];
+    int i;
+
+    // Units that came back go out again before new ones
+    if (app_sweep_data.retry_count > 0)
+    {
+        i = app_sweep_data.retry[app_sweep_data.retry_head];
+        app_sweep_data.retry_head = (app_sweep_data.retry_head + 1) % app_sweep_data.unit_count;
+        app_sweep_data.retry_count--;
+    }
+    else if (app_sweep_data.next_unit < app_sweep_data.unit_count)
+    {
+        i = app_sweep_data.next_unit++;
+    }
+    else
+    {
+        // Nothing pending, the worker stays idle in case a unit running elsewhere comes back
+        return;
+    }
+
+    app_sweep_unit_S* u = &app_sweep_data.units[i];
+    snprintf(line, sizeof(line), "UNIT %d %.17g %.17g %.17g %.17g %.17g %.17g %.17g %u\n",
+             i, u->simulationTimeSec, u->A, u->L, u->R, u->N, u->D, u->S, u->seed);
+    u->state = APP_SWEEP_UNIT_RUNNING;
+    u->attempts++;
+    worker->unit = i;
+    worker->deadline = app_sweep_now() + app_sweep_data.config.unitTimeout;
+    worker->idle = false;
+    if (!app_sweep_write_line(worker->fd, line))
+    {
+        app_sweep_retire(worker);
+    }
+}
+
+static void app_sweep_handle_line(app_sweep_worker_S* worker, const char* line)
+{
+    int unit;
+    double transmitted, success, dropped, collisions, wallSecs;
+
+    if (strcmp(line, "READY") == 0 && worker->unit < 0)
+    {
+        worker->idle = true;
+        worker->started = true;
+        app_sweep_data.dead_starts = 0;
+    }
+    else if (sscanf(line, "RESULT %d %lf %lf %lf %lf %lf", &unit, &transmitted, &success, &dropped, &collisions, &wallSecs) == 6 &&
+             unit == worker->unit)
+    {
+        app_sweep_unit_S* u = &app_sweep_data.units[unit];
+        u->state = APP_SWEEP_UNIT_DONE;
+        u->transmitted_packets = transmitted;
+        u->successfully_transmitted_packets = success;
+        u->dropped_packets = dropped;
+        u->collisions = collisions;
+        u->wall_secs = wallSecs;
+        app_sweep_data.remaining--;
+        worker->unit = -1;
+        worker->idle = true;
+    }
+    else if (sscanf(line, "FAIL %d", &unit) == 1 && unit == worker->unit)
+    {
+        app_sweep_unit_failed(unit);
+        worker->unit = -1;
+        worker->idle = true;
+    }
+    else
+    {
+        fprintf(stderr, "Unexpected line from worker %d: %s\r\n", (int)worker->pid, line);
+        app_sweep_retire(worker);
+    }
+}
+
+static bool app_sweep_write_text(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (out == NULL)
+    {
+        fprintf(stderr, "Cannot open sweep output %s\r\n", path);
+        return false;
+    }
+
+    fprintf(out, "# unit simTime A L R N D S seed transmitted success dropped collisions wallSecs\n");
+    for (int i = 0; i < app_sweep_data.unit_count; i++)
+    {
+        app_sweep_unit_S* u = &app_sweep_data.units[i];
+
+        fprintf(out, "%d %.17g %.17g %.17g %.17g %.17g %.17g %.17g %u ",
+                i, u->simulationTimeSec, u->A, u->L, u->R, u->N, u->D, u->S, u->seed);
+        if (u->state == APP_SWEEP_UNIT_DONE)
+        {
+            fprintf(out, "%f %f %f %f %f\n", u->transmitted_packets, u->successfully_transmitted_packets,
+                    u->dropped_packets, u->collisions, u->wall_secs);
+        }
+        else
+        {
+            fprintf(out, "FAILED\n");
+        }
+    }
+    return fclose(out) == 0;
+}
+
+static bool app_sweep_write_columnar(const char* path)
+{
+    static const results_file_column_S columns[] = {
+        { "unit",        RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+        { "done",        RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+        { "seed",        RESULTS_FILE_TYPE_INT64,  RESULTS_FILE_ENCODING_DELTA },
+        { "simTime",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "A",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "L",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "R",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "N",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "D",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "S",           RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "transmitted", RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "success",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "dropped",     RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "collisions",  RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_DELTA },
+        { "wallSecs",    RESULTS_FILE_TYPE_DOUBLE, RESULTS_FILE_ENCODING_PLAIN },
+    };
+    const int column_count = sizeof(columns)/sizeof(columns[0]);
+
+    results_file_writer_S* writer = results_file_open_writer(path, columns, column_count, RESULTS_FILE_DEFAULT_BLOCK_ROWS);
+    if (writer == NULL)
+    {
+        fprintf(stderr, "Cannot append to results file %s\r\n", path);
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < app_sweep_data.unit_count; i++)
+    {
+        app_sweep_unit_S* u = &app_sweep_data.units[i];
+        bool done = (u->state == APP_SWEEP_UNIT_DONE);
+        results_file_value_U row[] = {
+            { .i = i }, { .i = done }, { .i = u->seed },
+            { .d = u->simulationTimeSec }, { .d = u->A }, { .d = u->L }, { .d = u->R }, { .d = u->N }, { .d = u->D }, { .d = u->S },
+            { .d = done ? u->transmitted_packets : 0 }, { .d = done ? u->successfully_transmitted_packets : 0 },
+            { .d = done ? u->dropped_packets : 0 }, { .d = done ? u->collisions : 0 },
+            { .d = done ? u->wall_secs : 0 },
+        };
+        ok = results_file_append_row(writer, row) && ok;
+    }
+    return results_file_close_writer(writer) && ok;
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+bool app_sweep_init(const app_sweep_config_S* config)
+{
+    char line[APP_SWEEP_LINE_SIZE];
+    int capacity = 0;
+
+    memset(&app_sweep_data, 0, sizeof(app_sweep_data));
+    app_sweep_data.config = *config;
+
+    FILE* spec = fopen(config->specPath, "r");
+    if (spec == NULL)
+    {
+        fprintf(stderr, "Cannot open sweep spec %s\r\n", config->specPath);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), spec) != NULL)
+    {
+        app_sweep_unit_S u;
+
+        memset(&u, 0, sizeof(u));
+        char* start = line + strspn(line, " \t");
+        if (*start == '#' || *start == '\n' || *start == '\0')
+        {
+            continue;
+        }
+        if (sscanf(start, "%lf %lf %lf %lf %lf %lf %lf %u",
+                   &u.simulationTimeSec, &u.A, &u.L, &u.R, &u.N, &u.D, &u.S, &u.seed) != 8)
+        {
+            fprintf(stderr, "Skipping malformed sweep line: %s", line);
+            continue;
+        }
+
+        if (app_sweep_data.unit_count == capacity)
+        {
+            capacity = (capacity == 0) ? 64 : capacity*2;
+            app_sweep_data.units = realloc(app_sweep_data.units, capacity*sizeof(app_sweep_unit_S));
+        }
+        app_sweep_data.units[app_sweep_data.unit_count++] = u;
+    }
+    fclose(spec);
+
+    app_sweep_data.remaining = app_sweep_data.unit_count;
+    app_sweep_data.retry = malloc((app_sweep_data.unit_count + 1)*sizeof(int));
+    app_sweep_data.workers = calloc(config->workers, sizeof(app_sweep_worker_S));
+    for (int i = 0; i < config->workers; i++)
+    {
+        app_sweep_data.workers[i].fd = -1;
+        app_sweep_data.workers[i].unit = -1;
+    }
+    return true;
+}
+
+bool app_sweep_run(void)
+{
+    int workers = app_sweep_data.config.workers;
+    struct pollfd fds[workers];
+    bool abandoned = false;
+    int failed = 0;
+
+    // A dead worker shows up as a failed write, not a signal
+    signal(SIGPIPE, SIG_IGN);
+
+    while (app_sweep_data.remaining > 0)
+    {
+        int live = 0;
+        int timeout = app_sweep_check_deadlines();
+
+        // Retired workers don't wake the poll when they exit, so look for them every so often
+        app_sweep_reap();
+        if (app_sweep_data.exiting_count > 0 && (timeout < 0 || timeout > APP_SWEEP_REAP_POLL/1000))
+        {
+            timeout = APP_SWEEP_REAP_POLL/1000;
+        }
+
+        // Keep the pool full, a worker that died is replaced
+        for (int i = 0; i < workers; i++)
+        {
+            if (app_sweep_data.workers[i].fd < 0 && !app_sweep_spawn(&app_sweep_data.workers[i]))
+            {
+                fprintf(stderr, "Cannot start worker\r\n");
+            }
+            fds[i].fd = app_sweep_data.workers[i].fd;
+            fds[i].events = POLLIN;
+            live += (fds[i].fd >= 0);
+        }
+        // Workers that can't even start would be respawned forever
+        if (live == 0 || app_sweep_data.dead_starts > workers*(app_sweep_data.config.retries + 1))
+        {
+            fprintf(stderr, "Workers keep dying before taking work, giving up\r\n");
+            abandoned = true;
+            break;
+        }
+
+        if (poll(fds, workers, timeout) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            abandoned = true;
+            break;
+        }
+
+        for (int i = 0; i < workers; i++)
+        {
+            app_sweep_worker_S* worker = &app_sweep_data.workers[i];
+            if (fds[i].fd < 0 || fds[i].revents == 0)
+            {
+                continue;
+            }
+
+            ssize_t got = read(worker->fd, worker->line + worker->len, sizeof(worker->line) - 1 - worker->len);
+            if (got <= 0)
+            {
+                app_sweep_retire(worker);
+                continue;
+            }
+            worker->len += got;
+            worker->line[worker->len] = '\0';
+
+            // Handle every complete line, keep the partial one
+            char* eol;
+            while (worker->fd >= 0 && (eol = strchr(worker->line, '\n')) != NULL)
+            {
+                *eol = '\0';
+                app_sweep_handle_line(worker, worker->line);
+                worker->len -= (eol + 1 - worker->line);
+                memmove(worker->line, eol + 1, worker->len + 1);
+            }
+            if (worker->fd >= 0 && worker->len == sizeof(worker->line) - 1)
+            {
+                app_sweep_retire(worker);
+            }
+        }
+
+        // Idle workers pull the next unit, including ones that came back from a failed worker
+        for (int i = 0; i < workers; i++)
+        {
+            if (app_sweep_data.workers[i].fd >= 0 && app_sweep_data.workers[i].idle)
+            {
+                app_sweep_dispatch(&app_sweep_data.workers[i]);
+            }
+        }
+    }
+
+    // Tell every worker first so they all get their grace period at once
+    double exitBy = app_sweep_now() + APP_SWEEP_EXIT_GRACE;
+    for (int i = 0; i < workers; i++)
+    {
+        app_sweep_worker_S* worker = &app_sweep_data.workers[i];
+        if (worker->fd >= 0)
+        {
+            // Only left busy when giving up, it would not be listening for QUIT
+            if (worker->unit >= 0)
+            {
+                kill(worker->pid, SIGKILL);
+            }
+            app_sweep_write_line(worker->fd, "QUIT\n");
+            worker->exit_by = exitBy;
+        }
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        if (app_sweep_data.workers[i].fd >= 0)
+        {
+            app_sweep_retire(&app_sweep_data.workers[i]);
+        }
+    }
+    while (app_sweep_data.exiting_count > 0)
+    {
+        app_sweep_reap();
+        if (app_sweep_data.exiting_count > 0)
+        {
+            usleep(APP_SWEEP_REAP_POLL);
+        }
+    }
+
+    for (int i = 0; i < app_sweep_data.unit_count; i++)
+    {
+        failed += (app_sweep_data.units[i].state != APP_SWEEP_UNIT_DONE);
+    }
+    if (failed > 0)
+    {
+        fprintf(stderr, "%d of %d units failed\r\n", failed, app_sweep_data.unit_count);
+    }
+    return !abandoned && failed == 0;
+}
+
+bool app_sweep_write_results(void)
+{
+    bool ok = true;
+
+    if (app_sweep_data.config.outputPath != NULL)
+    {
+        ok = app_sweep_write_text(app_sweep_data.config.outputPath) && ok;
+    }
+    if (app_sweep_data.config.resultsPath != NULL)
+    {
+        ok = app_sweep_write_columnar(app_sweep_data.config.resultsPath) && ok;
+    }
+    return ok;
+}
+
+void app_sweep_deinit(void)
+{
+    free(app_sweep_data.units);
+    app_sweep_data.units = NULL;
+    free(app_sweep_data.retry);
+    app_sweep_data.retry = NULL;
+    free(app_sweep_data.workers);
+    app_sweep_data.workers = NULL;
+    free(app_sweep_data.exiting);
+    app_sweep_data.exiting = NULL;
+}
+
+void app_sweep_worker(int in_fd, int out_fd)
+{
+    char line[APP_SWEEP_LINE_SIZE];
+    FILE* in = fdopen(dup(in_fd), "r");
+
+    if (in == NULL || !app_sweep_write_line(out_fd, "READY\n"))
+    {
+        return;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        int unit;
+        double simulationTimeSec, A, L, R, N, D, S;
+        unsigned int seed;
+
+        if (strncmp(line, "QUIT", 4) == 0)
+        {
+            break;
+        }
+
+        if (sscanf(line, "UNIT %d %lf %lf %lf %lf %lf %lf %lf %u",
+                   &unit, &simulationTimeSec, &A, &L, &R, &N, &D, &S, &seed) != 9)
+        {
+            continue;
+        }
+
+        app_simulator_data_S* sim = NULL;
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (N >= 1 && A > 0 && R > 0 && S > 0)
+        {
+            sim = app_simulator_create(simulationTimeSec, A, L, R, N, D, S, seed);
+        }
+
+        if (sim == NULL)
+        {
+            snprintf(line, sizeof(line), "FAIL %d\n", unit);
+        }
+        else
+        {
+            app_simulator_results_S results;
+
+            while (app_simulator_step(sim) >= 0);
+            app_simulator_get_results(sim, &results);
+            app_simulator_destroy(sim);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            snprintf(line, sizeof(line), "RESULT %d %.17g %.17g %.17g %.17g %.6f\n", unit,
+                     results.transmitted_packets, results.successfully_transmitted_packets,
+                     results.dropped_packets, results.collisions,
+                     (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)*1e-9);
+        }
+
+        // The result doubles as the request for the next unit
+        if (!app_sweep_write_line(out_fd, line))
+        {
+            break;
+        }
+    }
+    fclose(in);
+}
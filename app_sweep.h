@@ -0,0 +1,90 @@
+/**
+ *  @file   app_sweep.h
+ *  @brief  API for the multi-process sweep coordinator
+ *
+ *  The coordinator reads a sweep spec, one work unit per line:
+ *
+ *      simTime A L R N D S seed
+ *
+ *  Blank lines and lines starting with '#' are skipped. Units are handed out to worker
+ *  processes over a line based protocol on a socket, workers pull a new unit every time
+ *  they finish one:
+ *
+ *      worker -> coordinator   READY
+ *      coordinator -> worker   UNIT <id> <simTime> <A> <L> <R> <N> <D> <S> <seed>
+ *      worker -> coordinator   RESULT <id> <transmitted> <success> <dropped> <collisions> <wallSecs>
+ *      worker -> coordinator   FAIL <id>
+ *      coordinator -> worker   QUIT
+ *
+ *  A worker speaks the protocol on any pair of file descriptors, so a worker can just as well
+ *  be `ssh host queueSim -W` on another machine. A worker that sits on a unit past the unit
+ *  timeout is killed like one that died, and the unit goes back in line.
+ */
+
+#ifndef APP_SWEEP_H
+#define APP_SWEEP_H
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define APP_SWEEP_DEFAULT_WORKERS (4)
+#define APP_SWEEP_DEFAULT_RETRIES (2)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef struct
+{
+    const char* specPath;
+    const char* outputPath;     // Text results, NULL for none
+    const char* resultsPath;    // Columnar results file to append to, NULL for none
+    int         workers;
+    int         retries;        // Extra attempts for a unit whose worker failed, died or timed out
+    double      unitTimeout;    // Seconds a worker gets per unit before it is killed, 0 for no limit
+    const char* workerCommand;  // Run through /bin/sh with the socket on stdin/stdout, NULL to fork locally
+} app_sweep_config_S;
+
+/*************************************************************************
+ *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ *  @brief  Initialize the coordinator and load the sweep spec
+ *  @return False if the spec could not be read
+ */
+bool app_sweep_init(const app_sweep_config_S* config);
+
+/**
+ *  @brief  De-initialize the coordinator
+ */
+void app_sweep_deinit(void);
+
+/**
+ *  @brief  Start the workers and hand out units until every unit is done or out of retries
+ *  @return False if any unit failed or the workers were given up on
+ */
+bool app_sweep_run(void);
+
+/**
+ *  @brief  Write the merged results, in spec order, to the text and columnar outputs
+ *  @return False if the output could not be written
+ */
+bool app_sweep_write_results(void);
+
+/**
+ *  @brief  Serve work units until told to quit
+ *  @param  in_fd Descriptor to read units from
+ *  @param  out_fd Descriptor to write results to
+ */
+void app_sweep_worker(int in_fd, int out_fd);
+
+#endif /* APP_SWEEP_H */
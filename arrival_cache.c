@@ -0,0 +1,527 @@
+/**
+ *  @file   arrival_cache.c
+ *  @brief  Shared, read-only arrival streams
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "arrival_cache.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define ARRIVAL_CACHE_MAGIC     "QSARRIVE"
+#define ARRIVAL_CACHE_VERSION   (1U)
+#define ARRIVAL_CACHE_PATH_SIZE (4096)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+/**
+ *  @brief  Start of an entry's memory, in memory or in a cache file. Followed by one int64_t
+ *          count per node, then each node's arrivals and end marker back to back. Cache files
+ *          are in host byte order, they are only meant for the machine that wrote them
+ */
+typedef struct
+{
+    char            magic[8];
+    uint32_t        version;
+    uint32_t        N;
+    double          simulationTimeSec;
+    double          A;
+    uint32_t        seed;
+    uint32_t        reserved;
+    int64_t         capacity;
+    timestamp_rng_S rng;
+} arrival_cache_header_S;
+
+struct arrival_cache_entry_S
+{
+    const arrival_cache_header_S* header;
+    size_t                 size;
+    bool                   mapped;      // Mapped from a cache file rather than allocated
+    const int64_t*         counts;
+    const double**         values;
+    int                    refs;
+    bool                   shared;      // In the registry, otherwise freed on its last release
+    uint64_t               last_used;
+    arrival_cache_entry_S* next;
+};
+
+typedef struct
+{
+    bool                   enabled;
+    char*                  dir;
+    arrival_cache_entry_S* entries;
+    uint64_t               clock;
+    pthread_mutex_t        lock;
+} arrival_cache_data_S;
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Size of the header and count table for N nodes, the arrivals start there
+ */
+static size_t arrival_cache_data_offset(int N);
+
+/**
+ * @brief Whether an entry holds the given key
+ */
+static bool arrival_cache_matches(const arrival_cache_header_S* header, double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity);
+
+/**
+ * @brief Generate the arrivals into a new allocation, exactly as a node queue would be filled
+ * @return NULL if there is no memory for them
+ */
+static arrival_cache_header_S* arrival_cache_generate(double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity, size_t* size);
+
+/**
+ * @brief Wrap entry memory, checking it is complete and for the given key
+ * @return NULL if the memory doesn't hold what was asked for or there is no memory for the entry
+ */
+static arrival_cache_entry_S* arrival_cache_wrap(const arrival_cache_header_S* header, size_t size, bool mapped,
+                                                 double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity);
+
+/**
+ * @brief Map a cache file
+ * @return NULL if the file is missing or doesn't hold what was asked for
+ */
+static arrival_cache_entry_S* arrival_cache_map(const char* path, double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity);
+
+/**
+ * @brief Map a cache file, writing it first if it is missing or bad
+ * @return Entry mapped from the file, or in memory if the file could not be written. NULL if
+ *         there is no memory for it
+ */
+static arrival_cache_entry_S* arrival_cache_load(double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity);
+
+/**
+ * @brief Free an entry and its memory
+ */
+static void arrival_cache_free(arrival_cache_entry_S* entry);
+
+/**
+ * @brief Free the least recently used idle entries beyond ARRIVAL_CACHE_MAX_IDLE, lock held
+ */
+static void arrival_cache_trim(void);
+
+/*************************************************************************
+ *            P R I V A T E   D A T A   D E C L A R A T I O N S          *
+ *************************************************************************/
+
+static arrival_cache_data_S arrival_cache_data = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static size_t arrival_cache_data_offset(int N)
+{
+    return sizeof(arrival_cache_header_S) + N*sizeof(int64_t);
+}
+
+static bool arrival_cache_matches(const arrival_cache_header_S* header, double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity)
+{
+    return header->simulationTimeSec == simulationTimeSec && header->A == A && header->N == (uint32_t)N &&
+           header->seed == seed && header->capacity == capacity;
+}
+
+static arrival_cache_header_S* arrival_cache_generate(double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity, size_t* size)
+{
+    size_t offset = arrival_cache_data_offset(N);
+    size_t allocated = offset + 1024*sizeof(double);
+    char* blob = malloc(allocated);
+    timestamp_rng_S rng;
+    int64_t counts[N];
+
+    if (blob == NULL)
+    {
+        return NULL;
+    }
+    timestamp_rng_seed(&rng, seed);
+
+    for (int i = 0; i < N; i++)
+    {
+        double currentTime = 0;
+        int64_t count = 0;
+
+        do
+        {
+            // Room for this arrival and the end marker
+            if (offset + 2*sizeof(double) > allocated)
+            {
+                allocated *= 2;
+                char* grown = realloc(blob, allocated);
+                if (grown == NULL)
+                {
+                    free(blob);
+                    return NULL;
+                }
+                blob = grown;
+            }
+
+            currentTime = timestamp_generate_r(&rng, A, currentTime);
+            if (currentTime >= simulationTimeSec)
+            {
+                currentTime = -1;
+            }
+
+            memcpy(blob + offset, &currentTime, sizeof(double));
+            offset += sizeof(double);
+            count++;
+        } while (currentTime != -1 && count < capacity);
+
+        // Keep reading -1 once the node runs dry, even if a backoff overrode the last arrival
+        currentTime = -1;
+        memcpy(blob + offset, &currentTime, sizeof(double));
+        offset += sizeof(double);
+        counts[i] = count;
+    }
+
+    arrival_cache_header_S* header = (arrival_cache_header_S*)blob;
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, ARRIVAL_CACHE_MAGIC, sizeof(header->magic));
+    header->version = ARRIVAL_CACHE_VERSION;
+    header->N = N;
+    header->simulationTimeSec = simulationTimeSec;
+    header->A = A;
+    header->seed = seed;
+    header->capacity = capacity;
+    header->rng = rng;
+    memcpy(blob + sizeof(arrival_cache_header_S), counts, N*sizeof(int64_t));
+
+    *size = offset;
+    return header;
+}
+
+static arrival_cache_entry_S* arrival_cache_wrap(const arrival_cache_header_S* header, size_t size, bool mapped,
+                                                 double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity)
+{
+    size_t offset = arrival_cache_data_offset(N);
+
+    if (size < offset || memcmp(header->magic, ARRIVAL_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ARRIVAL_CACHE_VERSION ||
+        !arrival_cache_matches(header, simulationTimeSec, A, N, seed, capacity))
+    {
+        return NULL;
+    }
+
+    arrival_cache_entry_S* entry = calloc(1, sizeof(arrival_cache_entry_S));
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+    entry->header = header;
+    entry->size = size;
+    entry->mapped = mapped;
+    entry->counts = (const int64_t*)(header + 1);
+    entry->values = malloc(N*sizeof(double*));
+    if (entry->values == NULL)
+    {
+        free(entry);
+        return NULL;
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        int64_t count = entry->counts[i];
+        if (count < 1 || count > capacity || (size - offset)/sizeof(double) < (size_t)count + 1)
+        {
+            free(entry->values);
+            free(entry);
+            return NULL;
+        }
+        entry->values[i] = (const double*)((const char*)header + offset);
+        offset += (count + 1)*sizeof(double);
+    }
+
+    return entry;
+}
+
+static arrival_cache_entry_S* arrival_cache_map(const char* path, double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity)
+{
+    struct stat st;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    arrival_cache_entry_S* entry = arrival_cache_wrap(map, st.st_size, true, simulationTimeSec, A, N, seed, capacity);
+    if (entry == NULL)
+    {
+        fprintf(stderr, "Replacing bad arrival cache file %s\r\n", path);
+        munmap(map, st.st_size);
+    }
+    return entry;
+}
+
+static arrival_cache_entry_S* arrival_cache_load(double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity)
+{
+    char path[ARRIVAL_CACHE_PATH_SIZE];
+    char temp[ARRIVAL_CACHE_PATH_SIZE + 32];
+    size_t size;
+
+    // Hex floats keep the key exact in the name
+    snprintf(path, sizeof(path), "%s/arrivals_T%a_A%a_N%d_seed%u_cap%lld.bin",
+             arrival_cache_data.dir, simulationTimeSec, A, N, seed, (long long)capacity);
+
+    arrival_cache_entry_S* entry = arrival_cache_map(path, simulationTimeSec, A, N, seed, capacity);
+    if (entry != NULL)
+    {
+        return entry;
+    }
+
+    // Write the file under a private name and rename it in place, so a reader only ever sees
+    // a complete file. Two processes racing here write the same bytes
+    arrival_cache_header_S* header = arrival_cache_generate(simulationTimeSec, A, N, seed, capacity, &size);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    bool written = (fd >= 0 && write(fd, header, size) == (ssize_t)size);
+    if (fd >= 0)
+    {
+        written = (close(fd) == 0) && written;
+    }
+    written = written && rename(temp, path) == 0;
+
+    // Use the file from here on, so this process shares its pages with everyone else
+    entry = written ? arrival_cache_map(path, simulationTimeSec, A, N, seed, capacity) : NULL;
+    if (entry != NULL)
+    {
+        free(header);
+        return entry;
+    }
+
+    if (!written)
+    {
+        unlink(temp);
+        fprintf(stderr, "Cannot write arrival cache file %s\r\n", path);
+    }
+    entry = arrival_cache_wrap(header, size, false, simulationTimeSec, A, N, seed, capacity);
+    if (entry == NULL)
+    {
+        free(header);
+    }
+    return entry;
+}
+
+static void arrival_cache_free(arrival_cache_entry_S* entry)
+{
+    if (entry->mapped)
+    {
+        munmap((void*)entry->header, entry->size);
+    }
+    else
+    {
+        free((void*)entry->header);
+    }
+    free(entry->values);
+    free(entry);
+}
+
+static void arrival_cache_trim(void)
+{
+    while (true)
+    {
+        arrival_cache_entry_S** oldest = NULL;
+        int idle = 0;
+
+        for (arrival_cache_entry_S** link = &arrival_cache_data.entries; *link != NULL; link = &(*link)->next)
+        {
+            if ((*link)->refs == 0)
+            {
+                idle++;
+                if (oldest == NULL || (*link)->last_used < (*oldest)->last_used)
+                {
+                    oldest = link;
+                }
+            }
+        }
+
+        if (idle <= ARRIVAL_CACHE_MAX_IDLE)
+        {
+            return;
+        }
+
+        arrival_cache_entry_S* entry = *oldest;
+        *oldest = entry->next;
+        arrival_cache_free(entry);
+    }
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+void arrival_cache_init(const char* dir)
+{
+    pthread_mutex_lock(&arrival_cache_data.lock);
+    arrival_cache_data.enabled = true;
+    free(arrival_cache_data.dir);
+    arrival_cache_data.dir = (dir != NULL) ? strdup(dir) : NULL;
+    pthread_mutex_unlock(&arrival_cache_data.lock);
+}
+
+void arrival_cache_deinit(void)
+{
+    pthread_mutex_lock(&arrival_cache_data.lock);
+    arrival_cache_entry_S** link = &arrival_cache_data.entries;
+    while (*link != NULL)
+    {
+        arrival_cache_entry_S* entry = *link;
+        *link = entry->next;
+        if (entry->refs == 0)
+        {
+            arrival_cache_free(entry);
+        }
+        else
+        {
+            // Still in use, it is freed on its last release
+            entry->shared = false;
+        }
+    }
+    arrival_cache_data.enabled = false;
+    free(arrival_cache_data.dir);
+    arrival_cache_data.dir = NULL;
+    pthread_mutex_unlock(&arrival_cache_data.lock);
+}
+
+const arrival_cache_entry_S* arrival_cache_acquire(double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity)
+{
+    arrival_cache_entry_S* entry = NULL;
+
+    pthread_mutex_lock(&arrival_cache_data.lock);
+    bool enabled = arrival_cache_data.enabled;
+    bool onDisk = (arrival_cache_data.dir != NULL);
+    for (entry = arrival_cache_data.entries; enabled && entry != NULL; entry = entry->next)
+    {
+        if (arrival_cache_matches(entry->header, simulationTimeSec, A, N, seed, capacity))
+        {
+            entry->refs++;
+            entry->last_used = ++arrival_cache_data.clock;
+            pthread_mutex_unlock(&arrival_cache_data.lock);
+            return entry;
+        }
+    }
+    pthread_mutex_unlock(&arrival_cache_data.lock);
+
+    // Generate or map outside the lock, other runs keep going meanwhile
+    entry = NULL;
+    if (enabled && onDisk)
+    {
+        entry = arrival_cache_load(simulationTimeSec, A, N, seed, capacity);
+    }
+    if (entry == NULL)
+    {
+        size_t size;
+        arrival_cache_header_S* header = arrival_cache_generate(simulationTimeSec, A, N, seed, capacity, &size);
+        entry = (header != NULL) ? arrival_cache_wrap(header, size, false, simulationTimeSec, A, N, seed, capacity) : NULL;
+        if (entry == NULL)
+        {
+            free(header);
+            return NULL;
+        }
+    }
+    entry->refs = 1;
+
+    if (!enabled)
+    {
+        return entry;
+    }
+
+    pthread_mutex_lock(&arrival_cache_data.lock);
+    // Somebody may have added the same arrivals while these were being made, use theirs
+    for (arrival_cache_entry_S* other = arrival_cache_data.entries; other != NULL; other = other->next)
+    {
+        if (arrival_cache_matches(other->header, simulationTimeSec, A, N, seed, capacity))
+        {
+            other->refs++;
+            other->last_used = ++arrival_cache_data.clock;
+            pthread_mutex_unlock(&arrival_cache_data.lock);
+            arrival_cache_free(entry);
+            return other;
+        }
+    }
+    entry->shared = true;
+    entry->last_used = ++arrival_cache_data.clock;
+    entry->next = arrival_cache_data.entries;
+    arrival_cache_data.entries = entry;
+    pthread_mutex_unlock(&arrival_cache_data.lock);
+
+    return entry;
+}
+
+void arrival_cache_release(const arrival_cache_entry_S* entry)
+{
+    arrival_cache_entry_S* e = (arrival_cache_entry_S*)entry;
+
+    if (e == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&arrival_cache_data.lock);
+    e->refs--;
+    if (e->refs == 0)
+    {
+        if (e->shared)
+        {
+            arrival_cache_trim();
+        }
+        else
+        {
+            arrival_cache_free(e);
+        }
+    }
+    pthread_mutex_unlock(&arrival_cache_data.lock);
+}
+
+int64_t arrival_cache_count(const arrival_cache_entry_S* entry, int node)
+{
+    return entry->counts[node];
+}
+
+const double* arrival_cache_values(const arrival_cache_entry_S* entry, int node)
+{
+    return entry->values[node];
+}
+
+void arrival_cache_get_rng(const arrival_cache_entry_S* entry, timestamp_rng_S* rng)
+{
+    *rng = entry->header->rng;
+}
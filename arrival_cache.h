@@ -0,0 +1,78 @@
+/**
+ *  @file   arrival_cache.h
+ *  @brief  API for shared, read-only arrival streams
+ *
+ *  The arrivals of a run depend only on simTime, A, N and the seed, so runs that differ in
+ *  L, R, D or S can share them. An entry holds the pre-generated arrivals of every node and the
+ *  random number state left after generating them. Entries are reference counted and kept in
+ *  the process while in use, plus a few idle ones for the next run. With a cache directory they
+ *  are also written to disk once and mapped read-only by every process that needs them.
+ */
+
+#ifndef ARRIVAL_CACHE_H
+#define ARRIVAL_CACHE_H
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timestamp_generator.h"
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define ARRIVAL_CACHE_MAX_IDLE (4)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef struct arrival_cache_entry_S arrival_cache_entry_S;
+
+/*************************************************************************
+ *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ *  @brief  Turn on sharing of arrival streams. Before this every acquire generates its own
+ *  @param  dir Directory for mappable cache files, NULL to share within the process only
+ */
+void arrival_cache_init(const char* dir);
+
+/**
+ *  @brief  Free the idle entries and stop sharing
+ */
+void arrival_cache_deinit(void);
+
+/**
+ *  @brief  Get the arrivals for a run, generating them if nobody has yet
+ *  @param  capacity Most arrivals per node, a node stops early once it holds this many
+ *  @return Entry to release once the run is done with it, NULL if there is no memory for it
+ */
+const arrival_cache_entry_S* arrival_cache_acquire(double simulationTimeSec, double A, int N, unsigned int seed, int64_t capacity);
+
+/**
+ *  @brief  Drop a reference taken by acquire
+ */
+void arrival_cache_release(const arrival_cache_entry_S* entry);
+
+/**
+ *  @brief  Number of arrivals of a node, counting the -1 that ends them
+ */
+int64_t arrival_cache_count(const arrival_cache_entry_S* entry, int node);
+
+/**
+ *  @brief  Arrivals of a node, followed by one more -1 as the end marker
+ */
+const double* arrival_cache_values(const arrival_cache_entry_S* entry, int node);
+
+/**
+ *  @brief  Random number state right after the arrivals were generated
+ */
+void arrival_cache_get_rng(const arrival_cache_entry_S* entry, timestamp_rng_S* rng);
+
+#endif /* ARRIVAL_CACHE_H */
@@ -6,12 +6,19 @@
  */
 
 #include "app_simulator.h"
+#include "app_bridge.h"
+#include "app_sweep.h"
+#include "app_record.h"
+#include "arrival_cache.h"
+#include "telemetry.h"
 #include "timestamp_generator.h"
 #include "queue.h"
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 // QUESTION 
-int main(void)
+int main(int argc, char** argv)
 {
     double simTime = 5000.0;
     double A = 5.0;
@@ -20,20 +27,240 @@ int main(void)
     double N = 20.0;
     double D = 10.0;
     double S = (2.0/3.0)*3.0*100000000.0;
-    
+    bool paramsGiven = false;       // Any of the above set with -d, -A, -L, -R, -N, -D or -S
+
+    // Bridged LAN, only used with -g. The delay defaults to one packet time
+    int segments = 0;
+    double bridgeDelay = 0;
+    bool bridgeDelayGiven = false;
+    double forwardProbability = 0.5;
+    unsigned int seed = APP_SIMULATOR_DEFAULT_SEED;
+
+    // Sweep coordinator, only used with -c
+    app_sweep_config_S sweep = {
+        .specPath = NULL, .outputPath = NULL, .resultsPath = NULL,
+        .workers = APP_SWEEP_DEFAULT_WORKERS, .retries = APP_SWEEP_DEFAULT_RETRIES, .unitTimeout = 0, .workerCommand = NULL,
+    };
+
+    // Sweep worker, and the arrival cache directory shared between processes
+    bool worker = false;
+    const char* cacheDir = NULL;
+
+    // Live telemetry page of a single run, only used with -T
+    const char* telemetryName = NULL;
+    long telemetryEvery = TELEMETRY_DEFAULT_EVERY;
+    bool telemetryEveryGiven = false;
+    bool quiet = false;
+
+    // Columnar record of a single run, -O outside a sweep
+    double recordInterval = 0;
+    bool recordIntervalGiven = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:A:L:R:N:D:S:g:b:p:s:c:o:O:I:j:r:t:e:WC:T:k:q")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': simTime = atof(optarg); paramsGiven = true; break;
+            case 'A': A = atof(optarg); paramsGiven = true; break;
+            case 'L': L = atof(optarg); paramsGiven = true; break;
+            case 'R': R = atof(optarg); paramsGiven = true; break;
+            case 'N': N = atof(optarg); paramsGiven = true; break;
+            case 'D': D = atof(optarg); paramsGiven = true; break;
+            case 'S': S = atof(optarg); paramsGiven = true; break;
+            case 'g': segments = atoi(optarg); break;
+            case 'b': bridgeDelay = atof(optarg); bridgeDelayGiven = true; break;
+            case 'p': forwardProbability = atof(optarg); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'c': sweep.specPath = optarg; break;
+            case 'o': sweep.outputPath = optarg; break;
+            case 'O': sweep.resultsPath = optarg; break;
+            case 'I': recordInterval = atof(optarg); recordIntervalGiven = true; break;
+            case 'j': sweep.workers = atoi(optarg); break;
+            case 'r': sweep.retries = atoi(optarg); break;
+            case 't': sweep.unitTimeout = atof(optarg); break;
+            case 'e': sweep.workerCommand = optarg; break;
+            case 'W': worker = true; break;
+            case 'C': cacheDir = optarg; break;
+            case 'T': telemetryName = optarg; break;
+            case 'k': telemetryEvery = atol(optarg); telemetryEveryGiven = true; break;
+            case 'q': quiet = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [params] [-T telemetry name [-k events per update]] [-O columnar output [-I interval]] [-q]\r\n"
+                                "       %s [params] -g segments [-b bridge delay] [-p forward probability] [-s seed]\r\n"
+                                "       %s -c sweep spec [-o output] [-O columnar output] [-j workers] [-r retries] [-t unit timeout] [-e worker command] [-C arrival cache directory]\r\n"
+                                "       %s -W [-C arrival cache directory]\r\n"
+                                "params: [-d sim time] [-A arrival rate] [-L packet length] [-R link rate] [-N nodes] [-D node distance] [-S propagation speed]\r\n",
+                        argv[0], argv[0], argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    // A sweep takes its points from the spec and a worker from its units
+    if (paramsGiven && (worker || sweep.specPath != NULL))
+    {
+        fprintf(stderr, "-d, -A, -L, -R, -N, -D and -S only apply to a single or bridged run\r\n");
+        return 1;
+    }
+    // A bridged run keeps no record and a sweep's record has no intervals
+    if ((sweep.resultsPath != NULL && sweep.specPath == NULL && (worker || segments > 0)) ||
+        (recordIntervalGiven && (sweep.resultsPath == NULL || worker || sweep.specPath != NULL || segments > 0)))
+    {
+        fprintf(stderr, "-O only applies to a single run or a sweep, -I to a single run with -O\r\n");
+        return 1;
+    }
+    // Only a single run publishes a telemetry page
+    if ((telemetryName != NULL && (worker || sweep.specPath != NULL || segments > 0)) ||
+        (telemetryEveryGiven && telemetryName == NULL))
+    {
+        fprintf(stderr, "-T only applies to a single run, -k to a single run with -T\r\n");
+        return 1;
+    }
+
+    // Sweep points that only change L, R, D or S reuse the arrivals of an earlier point
+    if (worker || sweep.specPath != NULL || cacheDir != NULL)
+    {
+        arrival_cache_init(cacheDir);
+    }
+
+    if (worker)
+    {
+        app_sweep_worker(STDIN_FILENO, STDOUT_FILENO);
+        arrival_cache_deinit();
+        return 0;
+    }
+
+    if (sweep.specPath != NULL)
+    {
+        if (sweep.workers < 1 || sweep.retries < 0 || sweep.unitTimeout < 0)
+        {
+            fprintf(stderr, "Need at least one worker and a non-negative retry count and unit timeout\r\n");
+            return 1;
+        }
+        if (sweep.outputPath == NULL && sweep.resultsPath == NULL)
+        {
+            sweep.outputPath = "sweep_results.txt";
+        }
+        if (!app_sweep_init(&sweep))
+        {
+            return 1;
+        }
+        // Whatever did finish is still written out, but a partial sweep must not look like a success
+        bool complete = app_sweep_run();
+        bool written = app_sweep_write_results();
+        app_sweep_deinit();
+        return (complete && written) ? 0 : 1;
+    }
+
+    if (simTime <= 0 || N < 1 || A <= 0 || L <= 0 || R <= 0 || D < 0 || S <= 0)
+    {
+        fprintf(stderr, "Need sim time, A, L, R and S > 0, N >= 1 and D >= 0\r\n");
+        return 1;
+    }
+
+    if (segments > 0)
+    {
+        bridgeDelay = bridgeDelayGiven ? bridgeDelay : L/R;
+        if (bridgeDelay <= 0)
+        {
+            fprintf(stderr, "Bridge delay must be > 0\r\n");
+            return 1;
+        }
+
+        app_bridge_config_S config = {
+            .simulationTimeSec = simTime, .A = A, .L = L, .R = R, .N = (int)N, .D = D, .S = S,
+            .segments = segments, .bridgeDelay = bridgeDelay,
+            .forwardProbability = forwardProbability, .seed = seed,
+        };
+
+        if (!app_bridge_init(&config))
+        {
+            return 1;
+        }
+        app_bridge_run();
+        app_bridge_print_results();
+        app_bridge_deinit();
+        return 0;
+    }
 
     double timeStamp = 0;
+    double lastTime = 0;
+    uint64_t events = 0;
+    long untilUpdate = telemetryEvery;
 
-    app_simulator_init(simTime, A, L, R, N, D, S);
+    if (telemetryName != NULL && telemetryEvery < 1)
+    {
+        fprintf(stderr, "Need at least one event per telemetry update\r\n");
+        return 1;
+    }
+    if (recordInterval < 0)
+    {
+        fprintf(stderr, "Record interval must be > 0\r\n");
+        return 1;
+    }
+
+    if (!app_simulator_init(simTime, A, L, R, N, D, S))
+    {
+        fprintf(stderr, "Not enough memory for the simulation\r\n");
+        return 1;
+    }
+
+    if (telemetryName != NULL && !telemetry_init(telemetryName, (int)N, simTime))
+    {
+        app_simulator_deinit();
+        return 1;
+    }
+
+    const char* recordPath = sweep.resultsPath;
+    if (recordPath != NULL)
+    {
+        app_record_config_S record = {
+            .path = recordPath, .simulationTimeSec = simTime, .A = A, .L = L, .R = R, .N = N, .D = D, .S = S,
+            .seed = APP_SIMULATOR_DEFAULT_SEED,
+            .interval = (recordInterval > 0) ? recordInterval : simTime/APP_RECORD_DEFAULT_INTERVALS,
+        };
+
+        if (!app_record_init(&record, app_simulator_default()))
+        {
+            if (telemetryName != NULL)
+            {
+                telemetry_deinit();
+            }
+            app_simulator_deinit();
+            return 1;
+        }
+    }
 
     while(timeStamp >= 0)
     {
         timeStamp =  app_simulator_run();
-	printf("The time is %f\r\n", timeStamp);
+        if (!quiet)
+        {
+	    printf("The time is %f\r\n", timeStamp);
+        }
+
+        // Without -T or -O this only adds a counter and a few compares to the loop
+        events++;
+        lastTime = (timeStamp > lastTime) ? timeStamp : lastTime;
+        if (recordPath != NULL)
+        {
+            app_record_event(timeStamp, events);
+        }
+        if (telemetryName != NULL && --untilUpdate == 0)
+        {
+            app_simulator_publish_telemetry(lastTime, events);
+            untilUpdate = telemetryEvery;
+        }
+    }
+    if (telemetryName != NULL)
+    {
+        app_simulator_publish_telemetry(lastTime, events);
+        telemetry_deinit();
     }
+    bool written = (recordPath == NULL) || app_record_finish(lastTime, events);
     app_simulator_print_results();
     app_simulator_deinit();
-    
+    return written ? 0 : 1;
 }
 
 /*
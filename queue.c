@@ -36,6 +36,16 @@
 Queue* Queue_Init(int64_t capacity, int64_t position)
 {
   Queue* q = malloc(sizeof(Queue));
+  if (q == NULL)
+  {
+    return NULL;
+  }
+  q->arr = malloc(sizeof(double) * capacity);
+  if (q->arr == NULL)
+  {
+    free(q);
+    return NULL;
+  }
   q->head = 0;
   q->tail = 0;
   q->size = 0;
@@ -43,7 +53,32 @@ Queue* Queue_Init(int64_t capacity, int64_t position)
   q->collision_counter = 0;
   q->position = position;
   q->capacity = capacity;
-  q->arr = malloc(sizeof(double) * capacity);
+  q->override_count = 0;
+  q->override_value = 0;
+  q->owns_arr = true;
+
+  return q;
+}
+
+Queue* Queue_View(const double* arr, int64_t size, int64_t position)
+{
+  Queue* q = malloc(sizeof(Queue));
+  if (q == NULL)
+  {
+    return NULL;
+  }
+  q->head = 0;
+  q->tail = size;
+  q->size = size;
+  q->backoff_value = 0;
+  q->collision_counter = 0;
+  q->position = position;
+  q->capacity = size + 1;
+  // Only ever read, Queue_Enqueue refuses to write to a queue that doesn't own its values
+  q->arr = (double*)arr;
+  q->override_count = 0;
+  q->override_value = 0;
+  q->owns_arr = false;
 
   return q;
 }
@@ -55,17 +90,25 @@ void Queue_Delete(Queue* q)
     return;
   }
 
-  free(q->arr);
+  if (q->owns_arr)
+  {
+    free(q->arr);
+  }
   free(q);
 }
 
 double Queue_Enqueue(Queue* q, double val)
 {
-  if (Queue_IsFull(q))
+  if (Queue_IsFull(q) || !q->owns_arr)
   {
     return -1;
   }
 
+  // An override past the last packet only covered the end marker this value replaces
+  if (q->override_count > q->size)
+  {
+    q->override_count = q->size;
+  }
   q->arr[q->tail] = val;
   q->tail = (q->tail + 1)%q->capacity;
   q->size++;
@@ -75,9 +118,13 @@ double Queue_Enqueue(Queue* q, double val)
 
 double Queue_Dequeue(Queue* q)
 {
-  double retVal = q->arr[q->head];
+  double retVal = Queue_PeekHead(q);
   q->head = (q->head + 1)%q->capacity;
   q->size--;
+  if (q->override_count > 0)
+  {
+    q->override_count--;
+  }
 
   return retVal;
 }
@@ -102,7 +149,34 @@ bool Queue_IsFull(const Queue* q)
 
 double Queue_PeekHead(const Queue* q)
 {
-    return q->arr[q->head];
+    return (q->override_count > 0) ? q->override_value : q->arr[q->head];
+}
+
+double Queue_Get(const Queue* q, int64_t index)
+{
+    return (index < q->override_count) ? q->override_value : q->arr[(q->head + index)%q->capacity];
+}
+
+int64_t Queue_Count_Arrived(const Queue* q, double time)
+{
+    int64_t low = 0, high = q->size;
+
+    // Arrival times are in order apart from the -1 that ends a node, which never arrives.
+    // Read arr itself so a packet backing off still counts from when it first arrived
+    while (low < high)
+    {
+        int64_t mid = low + (high - low)/2;
+        double value = q->arr[(q->head + mid)%q->capacity];
+        if (value >= 0 && value <= time)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
 }
 
 double Queue_PeekTail(const Queue* q)
@@ -127,13 +201,21 @@ int Queue_Collision_Count(const Queue* q)
 
 int Queue_update_times(Queue* q, double wait_time)
 {
-  int pos = q->head;
-  int count = 0;
-  do {
-    q->arr[pos] = wait_time;
-    ++pos;
+  int count = 1;
+  // Never walk past the tail, whatever sits behind the last packet is not part of the queue
+  while(count < q->size && Queue_Get(q, count) < wait_time)
+  {
     ++count;
-  } while(q->arr[pos]<wait_time);
+  }
+
+  // Packets are in time order and wait_time is never below the head, so the updated packets are
+  // always a run from the head with one value. The walk passes every earlier override unless
+  // wait_time equals it, in which case the longer run stands
+  if (count > q->override_count)
+  {
+    q->override_count = count;
+  }
+  q->override_value = wait_time;
   return count;
 }
 
@@ -27,6 +27,11 @@ typedef struct
   int64_t position, head, tail, size, capacity, collision_counter;
   double backoff_value;
   double* arr;
+  // Queue_update_times never writes to arr, it records that the first override_count packets
+  // now read as override_value. That lets a queue sit on top of read-only memory
+  int64_t override_count;
+  double override_value;
+  bool owns_arr;
 } Queue;
 
 /*************************************************************************
@@ -37,10 +42,20 @@ typedef struct
  *  @brief  Creates and initializes a queue object
  *  @param  capacity The maximum size of the queue to create
  *  @param position The node ID
- *  @return Pointer to the created queue
+ *  @return Pointer to the created queue, NULL if there is no memory for it
  */
 Queue* Queue_Init(int64_t capacity, int64_t position);
 
+/**
+ *  @brief  Creates a queue over values it does not own and never writes to, such as shared or
+ *          mapped memory. The queue holds all size values and cannot be enqueued to
+ *  @param  arr Values followed by one more for the end marker, size + 1 in all
+ *  @param  size Number of queued values
+ *  @param  position The node ID
+ *  @return Pointer to the created queue, NULL if there is no memory for it
+ */
+Queue* Queue_View(const double* arr, int64_t size, int64_t position);
+
 /**
  *  @brief  Deletes a queue object
  *  @param  q Pointer to the queue to delete
@@ -83,6 +98,20 @@ bool Queue_IsFull(const Queue* q);
  */
 double Queue_PeekHead(const Queue *q);
 
+/**
+ *  @brief  Returns a queued item without dequeueing it
+ *  @param  index Position from the front of the queue, 0 is the head
+ *  @return Item at that position
+ */
+double Queue_Get(const Queue* q, int64_t index);
+
+/**
+ *  @brief  Counts the queued packets that had arrived by a given time, backoffs aside
+ *  @param  time Time to count up to
+ *  @return Number of packets from the head with an arrival time at or before time
+ */
+int64_t Queue_Count_Arrived(const Queue* q, double time);
+
 /**
  *  @brief  Returns the item at the tail of the queue
  *          without dequeueing the item
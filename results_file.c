@@ -0,0 +1,769 @@
+/**
+ *  @file   results_file.c
+ *  @brief  Columnar binary results file
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "results_file.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define RESULTS_FILE_MAGIC          "QSRESULT"
+#define RESULTS_FILE_BLOCK_MAGIC    "QSRB"
+#define RESULTS_FILE_VERSION        (2U)
+#define RESULTS_FILE_HEADER_SIZE    (16)
+#define RESULTS_FILE_COLUMN_SIZE    (RESULTS_FILE_NAME_SIZE + 8)
+#define RESULTS_FILE_BLOCK_SIZE     (24)
+#define RESULTS_FILE_CHUNK_SIZE     (16)
+#define RESULTS_FILE_MAX_VARINT     (10)
+#define RESULTS_FILE_MAX_VALUE_SIZE (1 + RESULTS_FILE_MAX_VARINT)   // Longest encoding of one value
+#define RESULTS_FILE_MAX_COLUMNS    (4096)
+#define RESULTS_FILE_SCAN_SIZE      (65536)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+struct results_file_writer_S
+{
+    int                    fd;
+    results_file_column_S* columns;
+    int                    column_count;
+    int                    block_rows;
+    int                    rows;
+    results_file_value_U*  values;      // Row major, block_rows x column_count
+    uint8_t*               scratch;     // Encoded block
+};
+
+typedef struct
+{
+    uint64_t  offset;
+    uint64_t  length;
+    uint32_t  rows;
+    uint64_t* chunks;                   // Offset and length per column
+} results_file_block_S;
+
+struct results_file_reader_S
+{
+    int                    fd;
+    results_file_column_S* columns;
+    int                    column_count;
+    results_file_block_S*  blocks;
+    int                    block_count;
+    size_t                 rows;
+};
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Little endian field access
+ */
+static void results_file_put_u32(uint8_t* p, uint32_t value);
+static void results_file_put_u64(uint8_t* p, uint64_t value);
+static uint32_t results_file_get_u32(const uint8_t* p);
+static uint64_t results_file_get_u64(const uint8_t* p);
+
+/**
+ * @brief Varint encode, returns the bytes written
+ */
+static size_t results_file_put_varint(uint8_t* p, uint64_t value);
+
+/**
+ * @brief Varint decode, returns the bytes read or 0 if the value runs past end
+ */
+static size_t results_file_get_varint(const uint8_t* p, const uint8_t* end, uint64_t* value);
+
+/**
+ * @brief Encode one column of the buffered rows, returns the chunk length
+ */
+static size_t results_file_encode_column(const results_file_writer_S* writer, int column, uint8_t* out);
+
+/**
+ * @brief Decode a chunk into rows values
+ * @return False if the chunk is malformed
+ */
+static bool results_file_decode_column(const results_file_column_S* column, const uint8_t* chunk, size_t length, uint32_t rows, results_file_value_U* out);
+
+/**
+ * @brief Read and check the file header and column descriptions
+ * @return Column array, NULL if this is not a results file
+ */
+static results_file_column_S* results_file_read_header(int fd, int* column_count);
+
+/**
+ * @brief Create the file with its header, losing a race to another writer is fine
+ */
+static bool results_file_create(const char* path, const results_file_column_S* columns, int column_count);
+
+/**
+ * @brief Read exactly length bytes at offset
+ */
+static bool results_file_pread(int fd, void* buffer, size_t length, uint64_t offset);
+
+/**
+ * @brief FNV-1a over a block header and its chunk directory, with the checksum field taken as zero
+ */
+static uint32_t results_file_checksum(const uint8_t* header, size_t length);
+
+/**
+ * @brief Read and check the block header at offset: magic, checksum, and a chunk directory that
+ *        tiles the block exactly. The block itself may still run past the end of the file
+ * @param header Room for the block header and chunk directory
+ * @return Block length, 0 if there is no intact block header at offset
+ */
+static uint64_t results_file_check_block(int fd, uint64_t offset, uint64_t size, int column_count, uint8_t* header);
+
+/**
+ * @brief Find the next intact block header at or after offset
+ * @return Its offset, 0 if there is none
+ */
+static uint64_t results_file_find_block(int fd, uint64_t offset, uint64_t size, int column_count, uint8_t* header);
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static void results_file_put_u32(uint8_t* p, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (uint8_t)(value >> (8*i));
+    }
+}
+
+static void results_file_put_u64(uint8_t* p, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (uint8_t)(value >> (8*i));
+    }
+}
+
+static uint32_t results_file_get_u32(const uint8_t* p)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        value |= (uint32_t)p[i] << (8*i);
+    }
+    return value;
+}
+
+static uint64_t results_file_get_u64(const uint8_t* p)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        value |= (uint64_t)p[i] << (8*i);
+    }
+    return value;
+}
+
+static size_t results_file_put_varint(uint8_t* p, uint64_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t)value;
+    return n;
+}
+
+static size_t results_file_get_varint(const uint8_t* p, const uint8_t* end, uint64_t* value)
+{
+    uint64_t result = 0;
+    for (size_t n = 0; n < RESULTS_FILE_MAX_VARINT && p + n < end; n++)
+    {
+        result |= (uint64_t)(p[n] & 0x7F) << (7*n);
+        if ((p[n] & 0x80) == 0)
+        {
+            *value = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+static size_t results_file_encode_column(const results_file_writer_S* writer, int column, uint8_t* out)
+{
+    const results_file_column_S* desc = &writer->columns[column];
+    uint64_t previous = 0;
+    size_t length = 0;
+
+    for (int row = 0; row < writer->rows; row++)
+    {
+        results_file_value_U value = writer->values[row*writer->column_count + column];
+        uint64_t bits;
+
+        memcpy(&bits, &value, sizeof(bits));
+        if (desc->encoding == RESULTS_FILE_ENCODING_PLAIN)
+        {
+            results_file_put_u64(out + length, bits);
+            length += 8;
+        }
+        else if (desc->type == RESULTS_FILE_TYPE_INT64)
+        {
+            // Zigzag so small negative steps stay short
+            int64_t delta = (int64_t)(bits - previous);
+            length += results_file_put_varint(out + length, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+        }
+        else
+        {
+            // Close doubles share the sign, exponent and top of the mantissa, round ones end in zero
+            // bytes. Store the count of trailing zero bytes, then the rest as a varint
+            uint64_t x = bits ^ previous;
+            int zeros = 0;
+            while (zeros < 8 && ((x >> (8*zeros)) & 0xFF) == 0)
+            {
+                zeros++;
+            }
+            out[length++] = (uint8_t)zeros;
+            if (zeros < 8)
+            {
+                length += results_file_put_varint(out + length, x >> (8*zeros));
+            }
+        }
+        previous = bits;
+    }
+    return length;
+}
+
+static bool results_file_decode_column(const results_file_column_S* column, const uint8_t* chunk, size_t length, uint32_t rows, results_file_value_U* out)
+{
+    const uint8_t* p = chunk;
+    const uint8_t* end = chunk + length;
+    uint64_t previous = 0;
+
+    for (uint32_t row = 0; row < rows; row++)
+    {
+        uint64_t bits;
+
+        if (column->encoding == RESULTS_FILE_ENCODING_PLAIN)
+        {
+            if (end - p < 8)
+            {
+                return false;
+            }
+            bits = results_file_get_u64(p);
+            p += 8;
+        }
+        else if (column->type == RESULTS_FILE_TYPE_INT64)
+        {
+            uint64_t zigzag;
+            size_t n = results_file_get_varint(p, end, &zigzag);
+            if (n == 0)
+            {
+                return false;
+            }
+            p += n;
+            bits = previous + ((zigzag >> 1) ^ -(zigzag & 1));
+        }
+        else
+        {
+            uint64_t x = 0;
+            if (p >= end || *p > 8)
+            {
+                return false;
+            }
+            int zeros = *p++;
+            if (zeros < 8)
+            {
+                size_t n = results_file_get_varint(p, end, &x);
+                if (n == 0)
+                {
+                    return false;
+                }
+                p += n;
+                x <<= 8*zeros;
+            }
+            bits = previous ^ x;
+        }
+        memcpy(&out[row], &bits, sizeof(bits));
+        previous = bits;
+    }
+    return p == end;
+}
+
+static bool results_file_pread(int fd, void* buffer, size_t length, uint64_t offset)
+{
+    uint8_t* p = buffer;
+
+    while (length > 0)
+    {
+        ssize_t got = pread(fd, p, length, (off_t)offset);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            return false;
+        }
+        p += got;
+        offset += got;
+        length -= got;
+    }
+    return true;
+}
+
+static uint32_t results_file_checksum(const uint8_t* header, size_t length)
+{
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (i >= 16 && i < 20) ? 0 : header[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static uint64_t results_file_check_block(int fd, uint64_t offset, uint64_t size, int column_count, uint8_t* header)
+{
+    size_t header_size = RESULTS_FILE_BLOCK_SIZE + column_count*RESULTS_FILE_CHUNK_SIZE;
+
+    if (offset + header_size > size || !results_file_pread(fd, header, header_size, offset) ||
+        memcmp(header, RESULTS_FILE_BLOCK_MAGIC, 4) != 0 ||
+        results_file_get_u32(header + 16) != results_file_checksum(header, header_size))
+    {
+        return 0;
+    }
+
+    uint64_t length = results_file_get_u64(header + 8);
+    if (length < header_size)
+    {
+        return 0;
+    }
+
+    // The writer lays the chunks out back to back in column order
+    uint64_t expected = header_size;
+    for (int i = 0; i < column_count; i++)
+    {
+        const uint8_t* entry = header + RESULTS_FILE_BLOCK_SIZE + i*RESULTS_FILE_CHUNK_SIZE;
+        uint64_t chunk = results_file_get_u64(entry + 8);
+        if (results_file_get_u64(entry) != expected || chunk > length - expected)
+        {
+            return 0;
+        }
+        expected += chunk;
+    }
+    return (expected == length) ? length : 0;
+}
+
+static uint64_t results_file_find_block(int fd, uint64_t offset, uint64_t size, int column_count, uint8_t* header)
+{
+    uint8_t* window = malloc(RESULTS_FILE_SCAN_SIZE);
+    uint64_t found = 0;
+
+    // Windows overlap by the magic length less one so a magic across a boundary is still seen
+    while (found == 0 && offset + 4 <= size)
+    {
+        size_t length = (size - offset < RESULTS_FILE_SCAN_SIZE) ? size - offset : RESULTS_FILE_SCAN_SIZE;
+        if (!results_file_pread(fd, window, length, offset))
+        {
+            break;
+        }
+        for (size_t i = 0; found == 0 && i + 4 <= length; i++)
+        {
+            if (memcmp(window + i, RESULTS_FILE_BLOCK_MAGIC, 4) == 0 &&
+                results_file_check_block(fd, offset + i, size, column_count, header) > 0)
+            {
+                found = offset + i;
+            }
+        }
+        offset += length - 3;
+    }
+
+    free(window);
+    return found;
+}
+
+static results_file_column_S* results_file_read_header(int fd, int* column_count)
+{
+    uint8_t header[RESULTS_FILE_HEADER_SIZE];
+
+    if (!results_file_pread(fd, header, sizeof(header), 0) ||
+        memcmp(header, RESULTS_FILE_MAGIC, 8) != 0 ||
+        results_file_get_u32(header + 8) != RESULTS_FILE_VERSION)
+    {
+        return NULL;
+    }
+
+    uint32_t count = results_file_get_u32(header + 12);
+    if (count == 0 || count > RESULTS_FILE_MAX_COLUMNS)
+    {
+        return NULL;
+    }
+
+    uint8_t* raw = malloc(count*RESULTS_FILE_COLUMN_SIZE);
+    results_file_column_S* columns = calloc(count, sizeof(results_file_column_S));
+    if (!results_file_pread(fd, raw, count*RESULTS_FILE_COLUMN_SIZE, RESULTS_FILE_HEADER_SIZE))
+    {
+        free(raw);
+        free(columns);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t* p = raw + i*RESULTS_FILE_COLUMN_SIZE;
+        memcpy(columns[i].name, p, RESULTS_FILE_NAME_SIZE);
+        columns[i].name[RESULTS_FILE_NAME_SIZE - 1] = '\0';
+        columns[i].type = p[RESULTS_FILE_NAME_SIZE];
+        columns[i].encoding = p[RESULTS_FILE_NAME_SIZE + 1];
+    }
+    free(raw);
+
+    *column_count = count;
+    return columns;
+}
+
+static bool results_file_create(const char* path, const results_file_column_S* columns, int column_count)
+{
+    size_t size = RESULTS_FILE_HEADER_SIZE + column_count*RESULTS_FILE_COLUMN_SIZE;
+    uint8_t* header = calloc(1, size);
+    char* temp = malloc(strlen(path) + 32);
+    bool ok = false;
+
+    memcpy(header, RESULTS_FILE_MAGIC, 8);
+    results_file_put_u32(header + 8, RESULTS_FILE_VERSION);
+    results_file_put_u32(header + 12, column_count);
+    for (int i = 0; i < column_count; i++)
+    {
+        uint8_t* p = header + RESULTS_FILE_HEADER_SIZE + i*RESULTS_FILE_COLUMN_SIZE;
+        strncpy((char*)p, columns[i].name, RESULTS_FILE_NAME_SIZE - 1);
+        p[RESULTS_FILE_NAME_SIZE] = (uint8_t)columns[i].type;
+        p[RESULTS_FILE_NAME_SIZE + 1] = (uint8_t)columns[i].encoding;
+    }
+
+    // Write the header to a private file and link it in place, so nobody ever sees half a header
+    sprintf(temp, "%s.%ld.tmp", path, (long)getpid());
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd >= 0)
+    {
+        ok = (write(fd, header, size) == (ssize_t)size);
+        close(fd);
+        if (ok && link(temp, path) != 0 && errno != EEXIST)
+        {
+            ok = false;
+        }
+        unlink(temp);
+    }
+
+    free(temp);
+    free(header);
+    return ok;
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+results_file_writer_S* results_file_open_writer(const char* path, const results_file_column_S* columns, int column_count, int block_rows)
+{
+    if (column_count <= 0 || column_count > RESULTS_FILE_MAX_COLUMNS || block_rows <= 0)
+    {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR | O_APPEND);
+    if (fd < 0 && errno == ENOENT)
+    {
+        if (!results_file_create(path, columns, column_count))
+        {
+            return NULL;
+        }
+        fd = open(path, O_RDWR | O_APPEND);
+    }
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    // Appending to an existing file only makes sense with the same schema
+    int existing_count = 0;
+    results_file_column_S* existing = results_file_read_header(fd, &existing_count);
+    bool match = (existing != NULL && existing_count == column_count);
+    for (int i = 0; match && i < column_count; i++)
+    {
+        match = strncmp(existing[i].name, columns[i].name, RESULTS_FILE_NAME_SIZE - 1) == 0 &&
+                existing[i].type == columns[i].type &&
+                existing[i].encoding == columns[i].encoding;
+    }
+    if (!match)
+    {
+        free(existing);
+        close(fd);
+        return NULL;
+    }
+
+    results_file_writer_S* writer = calloc(1, sizeof(results_file_writer_S));
+    writer->fd = fd;
+    writer->columns = existing;
+    writer->column_count = column_count;
+    writer->block_rows = block_rows;
+    writer->values = malloc((size_t)block_rows*column_count*sizeof(results_file_value_U));
+    writer->scratch = malloc(RESULTS_FILE_BLOCK_SIZE + (size_t)column_count*RESULTS_FILE_CHUNK_SIZE +
+                             (size_t)block_rows*column_count*RESULTS_FILE_MAX_VALUE_SIZE);
+    return writer;
+}
+
+bool results_file_append_row(results_file_writer_S* writer, const results_file_value_U* row)
+{
+    memcpy(&writer->values[writer->rows*writer->column_count], row, writer->column_count*sizeof(results_file_value_U));
+    writer->rows++;
+
+    if (writer->rows == writer->block_rows)
+    {
+        return results_file_flush(writer);
+    }
+    return true;
+}
+
+bool results_file_flush(results_file_writer_S* writer)
+{
+    if (writer->rows == 0)
+    {
+        return true;
+    }
+
+    uint8_t* block = writer->scratch;
+    size_t length = RESULTS_FILE_BLOCK_SIZE + writer->column_count*RESULTS_FILE_CHUNK_SIZE;
+
+    for (int i = 0; i < writer->column_count; i++)
+    {
+        size_t chunk = results_file_encode_column(writer, i, block + length);
+        uint8_t* entry = block + RESULTS_FILE_BLOCK_SIZE + i*RESULTS_FILE_CHUNK_SIZE;
+        results_file_put_u64(entry, length);
+        results_file_put_u64(entry + 8, chunk);
+        length += chunk;
+    }
+
+    memcpy(block, RESULTS_FILE_BLOCK_MAGIC, 4);
+    results_file_put_u32(block + 4, writer->rows);
+    results_file_put_u64(block + 8, length);
+    results_file_put_u32(block + 16, 0);
+    results_file_put_u32(block + 20, 0);
+    results_file_put_u32(block + 16, results_file_checksum(block, RESULTS_FILE_BLOCK_SIZE + writer->column_count*RESULTS_FILE_CHUNK_SIZE));
+    writer->rows = 0;
+
+    // One write per block, O_APPEND keeps blocks from concurrent writers whole. A short write
+    // (out of space, say) leaves a torn block behind, readers step over it to the next one
+    return write(writer->fd, block, length) == (ssize_t)length;
+}
+
+bool results_file_close_writer(results_file_writer_S* writer)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    bool ok = results_file_flush(writer);
+    ok = (close(writer->fd) == 0) && ok;
+    free(writer->columns);
+    free(writer->values);
+    free(writer->scratch);
+    free(writer);
+    return ok;
+}
+
+results_file_reader_S* results_file_open_reader(const char* path)
+{
+    struct stat st;
+    int column_count = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    results_file_column_S* columns = results_file_read_header(fd, &column_count);
+    if (columns == NULL || fstat(fd, &st) != 0)
+    {
+        free(columns);
+        close(fd);
+        return NULL;
+    }
+
+    results_file_reader_S* reader = calloc(1, sizeof(results_file_reader_S));
+    reader->fd = fd;
+    reader->columns = columns;
+    reader->column_count = column_count;
+
+    // Index the blocks from their headers alone. A block still being written by another process
+    // shows up as running past the end of the file and ends the walk
+    size_t header_size = RESULTS_FILE_BLOCK_SIZE + column_count*RESULTS_FILE_CHUNK_SIZE;
+    uint8_t* header = malloc(header_size);
+    uint8_t* next_header = malloc(header_size);
+    uint64_t size = st.st_size;
+    uint64_t offset = RESULTS_FILE_HEADER_SIZE + column_count*RESULTS_FILE_COLUMN_SIZE;
+    int capacity = 0;
+
+    while (offset < size)
+    {
+        // A block counts once its own extent is within the file. A torn block claims bytes that
+        // really start the next writer's block, so when the block is not followed by the end of
+        // the file or another intact block header, look for an intact header inside it. Finding
+        // one there means this block is torn and the walk carries on from it. Otherwise the block
+        // is kept and the walk resyncs at the next intact header after it, whatever lies in
+        // between. There is none after a block still being written, which ends the walk
+        uint64_t length = results_file_check_block(fd, offset, size, column_count, header);
+        uint64_t next = offset + length;
+        if (length == 0 || next > size)
+        {
+            offset = results_file_find_block(fd, offset + 1, size, column_count, next_header);
+            if (offset == 0)
+            {
+                break;
+            }
+            continue;
+        }
+        if (next < size && results_file_check_block(fd, next, size, column_count, next_header) == 0)
+        {
+            uint64_t inner = results_file_find_block(fd, offset + 1, size, column_count, next_header);
+            if (inner != 0 && inner < next)
+            {
+                offset = inner;
+                continue;
+            }
+            next = (inner != 0) ? inner : size;
+        }
+
+        if (reader->block_count == capacity)
+        {
+            capacity = (capacity == 0) ? 16 : capacity*2;
+            reader->blocks = realloc(reader->blocks, capacity*sizeof(results_file_block_S));
+        }
+        results_file_block_S* block = &reader->blocks[reader->block_count++];
+        block->offset = offset;
+        block->length = length;
+        block->rows = results_file_get_u32(header + 4);
+        block->chunks = malloc(2*column_count*sizeof(uint64_t));
+        for (int i = 0; i < 2*column_count; i++)
+        {
+            block->chunks[i] = results_file_get_u64(header + RESULTS_FILE_BLOCK_SIZE + 8*i);
+        }
+        reader->rows += block->rows;
+        offset = next;
+    }
+    free(header);
+    free(next_header);
+
+    return reader;
+}
+
+void results_file_close_reader(results_file_reader_S* reader)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < reader->block_count; i++)
+    {
+        free(reader->blocks[i].chunks);
+    }
+    free(reader->blocks);
+    free(reader->columns);
+    close(reader->fd);
+    free(reader);
+}
+
+int results_file_column_count(const results_file_reader_S* reader)
+{
+    return reader->column_count;
+}
+
+const results_file_column_S* results_file_column(const results_file_reader_S* reader, int column)
+{
+    return &reader->columns[column];
+}
+
+int results_file_find_column(const results_file_reader_S* reader, const char* name)
+{
+    for (int i = 0; i < reader->column_count; i++)
+    {
+        if (strcmp(reader->columns[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+size_t results_file_row_count(const results_file_reader_S* reader)
+{
+    return reader->rows;
+}
+
+size_t results_file_column_size(const results_file_reader_S* reader, int column)
+{
+    size_t size = 0;
+    for (int i = 0; i < reader->block_count; i++)
+    {
+        size += reader->blocks[i].chunks[2*column + 1];
+    }
+    return size;
+}
+
+results_file_value_U* results_file_read_column(results_file_reader_S* reader, int column)
+{
+    if (column < 0 || column >= reader->column_count)
+    {
+        return NULL;
+    }
+
+    results_file_value_U* values = malloc((reader->rows + 1)*sizeof(results_file_value_U));
+    uint8_t* chunk = NULL;
+    size_t chunk_capacity = 0;
+    size_t row = 0;
+
+    for (int i = 0; i < reader->block_count; i++)
+    {
+        const results_file_block_S* block = &reader->blocks[i];
+        uint64_t offset = block->chunks[2*column];
+        uint64_t length = block->chunks[2*column + 1];
+
+        if (offset > block->length || length > block->length - offset)
+        {
+            free(chunk);
+            free(values);
+            return NULL;
+        }
+        if (length > chunk_capacity)
+        {
+            chunk_capacity = length;
+            chunk = realloc(chunk, chunk_capacity);
+        }
+        if (!results_file_pread(reader->fd, chunk, length, block->offset + offset) ||
+            !results_file_decode_column(&reader->columns[column], chunk, length, block->rows, values + row))
+        {
+            free(chunk);
+            free(values);
+            return NULL;
+        }
+        row += block->rows;
+    }
+
+    free(chunk);
+    return values;
+}
@@ -0,0 +1,143 @@
+/**
+ *  @file   results_file.h
+ *  @brief  Columnar binary results file
+ *
+ *  Layout, all integers little endian:
+ *
+ *      file header     "QSRESULT", u32 version, u32 column count
+ *      column          char name[32], u8 type, u8 encoding, 6 bytes padding    (one per column)
+ *      block           "QSRB", u32 row count, u64 block length,                (repeated)
+ *                      u32 checksum, 4 bytes padding
+ *                      u64 offset, u64 length per column, relative to the block
+ *                      column chunks
+ *
+ *  Rows are buffered and written a block at a time with a single O_APPEND write, so any number
+ *  of writers can append to the same file. A reader walks the block headers and only reads the
+ *  chunks of the columns it asks for. The checksum covers the block header and chunk directory,
+ *  so a block torn by a short write is told apart and stepped over.
+ */
+
+#ifndef RESULTS_FILE_H
+#define RESULTS_FILE_H
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define RESULTS_FILE_NAME_SIZE          (32)
+#define RESULTS_FILE_DEFAULT_BLOCK_ROWS (4096)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef enum
+{
+    RESULTS_FILE_TYPE_INT64,
+    RESULTS_FILE_TYPE_DOUBLE,
+} results_file_type_E;
+
+typedef enum
+{
+    RESULTS_FILE_ENCODING_PLAIN,    // 8 bytes per value
+    RESULTS_FILE_ENCODING_DELTA,    // Varint of the change from the previous value, XOR for doubles
+} results_file_encoding_E;
+
+typedef struct
+{
+    char                    name[RESULTS_FILE_NAME_SIZE];
+    results_file_type_E     type;
+    results_file_encoding_E encoding;
+} results_file_column_S;
+
+typedef union
+{
+    int64_t i;
+    double  d;
+} results_file_value_U;
+
+typedef struct results_file_writer_S results_file_writer_S;
+typedef struct results_file_reader_S results_file_reader_S;
+
+/*************************************************************************
+ *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ *  @brief  Open a results file for appending, creating it if needed
+ *  @param  columns Schema, must match the file's if it already exists
+ *  @param  block_rows Rows buffered before a block is written
+ *  @return NULL if the file could not be opened or has a different schema
+ */
+results_file_writer_S* results_file_open_writer(const char* path, const results_file_column_S* columns, int column_count, int block_rows);
+
+/**
+ *  @brief  Buffer one row, one value per column, writing a block when the buffer fills
+ *  @return False if a block write failed
+ */
+bool results_file_append_row(results_file_writer_S* writer, const results_file_value_U* row);
+
+/**
+ *  @brief  Write the buffered rows as a block
+ *  @return False if the write failed
+ */
+bool results_file_flush(results_file_writer_S* writer);
+
+/**
+ *  @brief  Flush and close the writer
+ *  @return False if the last write failed
+ */
+bool results_file_close_writer(results_file_writer_S* writer);
+
+/**
+ *  @brief  Open a results file and index its blocks
+ *  @return NULL if the file is missing or not a results file
+ */
+results_file_reader_S* results_file_open_reader(const char* path);
+
+/**
+ *  @brief  Close the reader
+ */
+void results_file_close_reader(results_file_reader_S* reader);
+
+/**
+ *  @brief  Number of columns in the file
+ */
+int results_file_column_count(const results_file_reader_S* reader);
+
+/**
+ *  @brief  Column description
+ */
+const results_file_column_S* results_file_column(const results_file_reader_S* reader, int column);
+
+/**
+ *  @brief  Index of the column with the given name
+ *  @return -1 if there is none
+ */
+int results_file_find_column(const results_file_reader_S* reader, const char* name);
+
+/**
+ *  @brief  Number of rows over all blocks
+ */
+size_t results_file_row_count(const results_file_reader_S* reader);
+
+/**
+ *  @brief  Bytes the column takes on disk over all blocks
+ */
+size_t results_file_column_size(const results_file_reader_S* reader, int column);
+
+/**
+ *  @brief  Load every value of one column, reading only that column's chunks
+ *  @return Array of results_file_row_count values, to be freed by the caller, NULL on error
+ */
+results_file_value_U* results_file_read_column(results_file_reader_S* reader, int column);
+
+#endif /* RESULTS_FILE_H */
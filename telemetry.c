@@ -0,0 +1,298 @@
+/**
+ *  @file   telemetry.c
+ *  @brief  Live telemetry page of a running simulation
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "telemetry.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define TELEMETRY_MAGIC     "QSTELEMY"
+#define TELEMETRY_VERSION   (1U)
+#define TELEMETRY_NAME_SIZE (256)
+#define TELEMETRY_READ_TRIES (1000)    // An update takes microseconds, a page odd for this long has lost its writer
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+/**
+ *  @brief  Layout of the shared memory object, in host byte order
+ */
+typedef struct
+{
+    char               magic[8];
+    uint32_t           version;
+    uint32_t           N;
+    _Atomic uint64_t   seq;         // Odd while an update is being written
+    telemetry_sample_S sample;
+    int64_t            backlog[];
+} telemetry_page_S;
+
+typedef struct
+{
+    telemetry_page_S* page;
+    size_t            size;
+    char              name[TELEMETRY_NAME_SIZE];
+    struct timespec   start;
+    double            last_wall_secs;
+    uint64_t          last_events;
+} telemetry_data_S;
+
+struct telemetry_reader_S
+{
+    const telemetry_page_S* page;
+    size_t                  size;
+};
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Shared memory name with the leading / that shm_open wants
+ */
+static void telemetry_name(const char* name, char* out);
+
+/**
+ * @brief Size of a page with N nodes
+ */
+static size_t telemetry_size(int N);
+
+/**
+ * @brief Write the page under the sequence counter
+ */
+static void telemetry_write(const telemetry_sample_S* sample, const int64_t* backlog);
+
+/*************************************************************************
+ *            P R I V A T E   D A T A   D E C L A R A T I O N S          *
+ *************************************************************************/
+
+static telemetry_data_S telemetry_data;
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static void telemetry_name(const char* name, char* out)
+{
+    snprintf(out, TELEMETRY_NAME_SIZE, "%s%s", (name[0] == '/') ? "" : "/", name);
+}
+
+static size_t telemetry_size(int N)
+{
+    return sizeof(telemetry_page_S) + N*sizeof(int64_t);
+}
+
+static void telemetry_write(const telemetry_sample_S* sample, const int64_t* backlog)
+{
+    telemetry_page_S* page = telemetry_data.page;
+    uint64_t seq = atomic_load_explicit(&page->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&page->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    page->sample = *sample;
+    if (backlog != NULL)
+    {
+        memcpy(page->backlog, backlog, page->N*sizeof(int64_t));
+    }
+
+    atomic_store_explicit(&page->seq, seq + 2, memory_order_release);
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+bool telemetry_init(const char* name, int N, double simulationTimeSec)
+{
+    memset(&telemetry_data, 0, sizeof(telemetry_data));
+    telemetry_name(name, telemetry_data.name);
+    telemetry_data.size = telemetry_size(N);
+
+    // A page left by a run that died is replaced, readers still holding it keep the old one
+    shm_unlink(telemetry_data.name);
+    int fd = shm_open(telemetry_data.name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        perror("Cannot create telemetry page");
+        return false;
+    }
+    if (ftruncate(fd, telemetry_data.size) != 0)
+    {
+        perror("Cannot size telemetry page");
+        close(fd);
+        shm_unlink(telemetry_data.name);
+        return false;
+    }
+
+    void* map = mmap(NULL, telemetry_data.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("Cannot map telemetry page");
+        shm_unlink(telemetry_data.name);
+        return false;
+    }
+
+    // The object starts zeroed, so the page reads as mid-update until the header is in place
+    telemetry_data.page = map;
+    atomic_store_explicit(&telemetry_data.page->seq, 1, memory_order_relaxed);
+    telemetry_data.page->N = N;
+    telemetry_data.page->version = TELEMETRY_VERSION;
+    telemetry_data.page->sample = (telemetry_sample_S){
+        .pid = getpid(), .state = TELEMETRY_STATE_RUNNING, .N = N, .sim_end_time = simulationTimeSec,
+    };
+    atomic_thread_fence(memory_order_release);
+    memcpy(telemetry_data.page->magic, TELEMETRY_MAGIC, sizeof(telemetry_data.page->magic));
+    atomic_store_explicit(&telemetry_data.page->seq, 2, memory_order_release);
+
+    clock_gettime(CLOCK_MONOTONIC, &telemetry_data.start);
+    return true;
+}
+
+void telemetry_deinit(void)
+{
+    if (telemetry_data.page == NULL)
+    {
+        return;
+    }
+
+    telemetry_sample_S sample = telemetry_data.page->sample;
+    sample.state = TELEMETRY_STATE_COMPLETE;
+    telemetry_write(&sample, NULL);
+
+    shm_unlink(telemetry_data.name);
+    munmap(telemetry_data.page, telemetry_data.size);
+    telemetry_data.page = NULL;
+}
+
+void telemetry_publish(const telemetry_sample_S* sample, const int64_t* backlog)
+{
+    telemetry_sample_S update = *sample;
+    struct timespec now;
+
+    if (telemetry_data.page == NULL)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    update.pid = telemetry_data.page->sample.pid;
+    update.state = TELEMETRY_STATE_RUNNING;
+    update.N = telemetry_data.page->N;
+    update.sim_end_time = telemetry_data.page->sample.sim_end_time;
+    update.wall_secs = (now.tv_sec - telemetry_data.start.tv_sec) + (now.tv_nsec - telemetry_data.start.tv_nsec)*1e-9;
+    update.events_per_sec = (update.wall_secs > telemetry_data.last_wall_secs) ?
+        (update.events - telemetry_data.last_events)/(update.wall_secs - telemetry_data.last_wall_secs) : 0;
+    telemetry_data.last_wall_secs = update.wall_secs;
+    telemetry_data.last_events = update.events;
+
+    telemetry_write(&update, backlog);
+}
+
+telemetry_reader_S* telemetry_reader_open(const char* name)
+{
+    char path[TELEMETRY_NAME_SIZE];
+    struct stat st;
+
+    telemetry_name(name, path);
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(telemetry_page_S))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    // The magic goes in last, a page still being set up is turned away like a foreign one
+    const telemetry_page_S* page = map;
+    if (memcmp(page->magic, TELEMETRY_MAGIC, sizeof(page->magic)) != 0 || page->version != TELEMETRY_VERSION ||
+        telemetry_size(page->N) > (size_t)st.st_size)
+    {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    telemetry_reader_S* reader = malloc(sizeof(telemetry_reader_S));
+    reader->page = page;
+    reader->size = st.st_size;
+    return reader;
+}
+
+void telemetry_reader_close(telemetry_reader_S* reader)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+
+    munmap((void*)reader->page, reader->size);
+    free(reader);
+}
+
+int telemetry_reader_node_count(const telemetry_reader_S* reader)
+{
+    return reader->page->N;
+}
+
+bool telemetry_reader_read(const telemetry_reader_S* reader, telemetry_sample_S* sample, int64_t* backlog)
+{
+    const telemetry_page_S* page = reader->page;
+    uint64_t before, after;
+
+    for (int i = 0; i < TELEMETRY_READ_TRIES; i++)
+    {
+        before = atomic_load_explicit((_Atomic uint64_t*)&page->seq, memory_order_acquire);
+        if (before & 1)
+        {
+            sched_yield();
+            continue;
+        }
+
+        *sample = page->sample;
+        memcpy(backlog, page->backlog, page->N*sizeof(int64_t));
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit((_Atomic uint64_t*)&page->seq, memory_order_relaxed);
+        if (before == after)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t telemetry_reader_pid(const telemetry_reader_S* reader)
+{
+    // Set before the magic and never changed, so it needs no sequence check
+    return reader->page->sample.pid;
+}
@@ -0,0 +1,113 @@
+/**
+ *  @file   telemetry.h
+ *  @brief  API for the live telemetry page of a running simulation
+ *
+ *  The page is a POSIX shared memory object that a simulation rewrites every so many
+ *  events and any number of readers poll. It is guarded by a sequence counter rather than a
+ *  lock: the writer bumps it to odd before an update and back to even after, a reader retries
+ *  until it copies the page between two equal even counts. The writer never waits on a reader.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define TELEMETRY_DEFAULT_EVERY (100000)
+
+/*************************************************************************
+ *                            T Y P E D E S                              *
+ *************************************************************************/
+
+typedef enum
+{
+    TELEMETRY_STATE_RUNNING,
+    TELEMETRY_STATE_COMPLETE,
+} telemetry_state_E;
+
+/**
+ *  @brief  One update of the page, besides the per-node backlog
+ */
+typedef struct
+{
+    int64_t  pid;
+    int32_t  state;                 // telemetry_state_E
+    int32_t  N;
+    uint64_t events;
+    double   sim_time;
+    double   sim_end_time;
+    double   wall_secs;             // Since the page was created
+    double   events_per_sec;        // Over the last update interval
+    double   transmitted_packets;
+    double   successfully_transmitted_packets;
+    double   dropped_packets;
+    double   collisions;
+} telemetry_sample_S;
+
+typedef struct telemetry_reader_S telemetry_reader_S;
+
+/*************************************************************************
+ *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ *  @brief  Create the telemetry page, replacing any left over under the same name
+ *  @param  name Shared memory name, a leading / is added if missing
+ *  @param  N Number of nodes, one backlog entry each
+ *  @param  simulationTimeSec Sim time the run ends at
+ *  @return False if the page could not be created
+ */
+bool telemetry_init(const char* name, int N, double simulationTimeSec);
+
+/**
+ *  @brief  Mark the run complete and remove the page. Readers that have it open keep the final update
+ */
+void telemetry_deinit(void);
+
+/**
+ *  @brief  Publish an update. Only the counters, sim time and backlog are taken from the
+ *          caller, the rest is filled in here
+ *  @param  sample Counters and sim time
+ *  @param  backlog Packets arrived but not yet sent, one per node
+ */
+void telemetry_publish(const telemetry_sample_S* sample, const int64_t* backlog);
+
+/**
+ *  @brief  Open a telemetry page for reading
+ *  @return NULL if there is no valid page under the name
+ */
+telemetry_reader_S* telemetry_reader_open(const char* name);
+
+/**
+ *  @brief  Close a telemetry page
+ */
+void telemetry_reader_close(telemetry_reader_S* reader);
+
+/**
+ *  @brief  Number of nodes on the page
+ */
+int telemetry_reader_node_count(const telemetry_reader_S* reader);
+
+/**
+ *  @brief  Process id of the writer
+ */
+int64_t telemetry_reader_pid(const telemetry_reader_S* reader);
+
+/**
+ *  @brief  Copy out a consistent update, retrying a bounded number of times while the writer is
+ *          in the middle of one
+ *  @param  backlog Room for telemetry_reader_node_count entries
+ *  @return False if no consistent update was seen, the writer may have died mid-update
+ */
+bool telemetry_reader_read(const telemetry_reader_S* reader, telemetry_sample_S* sample, int64_t* backlog);
+
+#endif /* TELEMETRY_H */
@@ -54,3 +54,54 @@ int return_random(int upper)
 {
     return ( rand() % (upper+1) );
 }
+
+void timestamp_rng_seed(timestamp_rng_S* rng, unsigned int seed)
+{
+    int32_t word = (seed == 0) ? 1 : (int32_t)seed;
+
+    rng->state[0] = word;
+    for (int i = 1; i < TIMESTAMP_RNG_DEG; i++)
+    {
+        // 16807 * word % 2147483647 without overflow
+        int32_t hi = word / 127773;
+        int32_t lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0)
+        {
+            word += 2147483647;
+        }
+        rng->state[i] = word;
+    }
+    rng->front = TIMESTAMP_RNG_SEP;
+    rng->rear = 0;
+
+    // Discard the first values like srand does
+    for (int i = 0; i < 10*TIMESTAMP_RNG_DEG; i++)
+    {
+        timestamp_rng_next(rng);
+    }
+}
+
+int timestamp_rng_next(timestamp_rng_S* rng)
+{
+    uint32_t val = (uint32_t)rng->state[rng->front] + (uint32_t)rng->state[rng->rear];
+
+    rng->state[rng->front] = (int32_t)val;
+    rng->front = (rng->front + 1)%TIMESTAMP_RNG_DEG;
+    rng->rear = (rng->rear + 1)%TIMESTAMP_RNG_DEG;
+
+    return (int)(val >> 1);
+}
+
+double timestamp_generate_r(timestamp_rng_S* rng, double lambda, double current_time)
+{
+    double u_rand = (double)timestamp_rng_next(rng) / (double)RAND_MAX;
+    double exp_rand = (-1/(double)lambda) * logf( (1 - u_rand));
+
+    return (exp_rand + current_time);
+}
+
+int return_random_r(timestamp_rng_S* rng, int upper)
+{
+    return ( timestamp_rng_next(rng) % (upper+1) );
+}
@@ -18,10 +18,24 @@
  *                            D E F I N E S                              *
  *************************************************************************/
 
+#define TIMESTAMP_RNG_DEG (31)
+#define TIMESTAMP_RNG_SEP (3)
+
 /*************************************************************************
  *                            T Y P E D E S                              *
  *************************************************************************/
 
+/**
+ *  @brief  Per-instance random number state. Same additive feedback generator as glibc rand(),
+ *          so a stream seeded with 1 matches rand() without srand(). Plain data, copy it to clone
+ */
+typedef struct
+{
+    int32_t state[TIMESTAMP_RNG_DEG];
+    int     front;
+    int     rear;
+} timestamp_rng_S;
+
 /*************************************************************************
  *          P U B L I C   F U N C T I O N   D E C L A R A T I O N S      *
  *************************************************************************/
@@ -40,4 +54,25 @@ double timestamp_generate(double lambda, double current_time);
  * @brief Select a random integer from 0 to a specified upper bound. Input must be > 0
  */
 int return_random(int upper);
+
+/**
+ *  @brief  Seed a random number state
+ */
+void timestamp_rng_seed(timestamp_rng_S* rng, unsigned int seed);
+
+/**
+ *  @brief  Next value in [0, RAND_MAX] from a random number state
+ */
+int timestamp_rng_next(timestamp_rng_S* rng);
+
+/**
+ *  @brief  timestamp_generate drawing from a random number state instead of rand()
+ */
+double timestamp_generate_r(timestamp_rng_S* rng, double lambda, double current_time);
+
+/**
+ *  @brief  return_random drawing from a random number state instead of rand()
+ */
+int return_random_r(timestamp_rng_S* rng, int upper);
+
 #endif /* TIMESTAMP_GENERATOR_H */
\ No newline at end of file
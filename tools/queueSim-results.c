@@ -0,0 +1,196 @@
+/**
+ *  @file   queueSim-results.c
+ *  @brief  Inspect columnar results files and export them as CSV
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "results_file.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Print one value in its column's type
+ */
+static void print_value(FILE* out, const results_file_column_S* column, results_file_value_U value);
+
+/**
+ * @brief Print the schema, row count and on-disk size per column
+ */
+static int command_info(results_file_reader_S* reader);
+
+/**
+ * @brief Print one column, one value per line
+ */
+static int command_dump(results_file_reader_S* reader, const char* name);
+
+/**
+ * @brief Print the named columns, or all of them, as CSV with a header line
+ */
+static int command_csv(results_file_reader_S* reader, int name_count, char** names);
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static void print_value(FILE* out, const results_file_column_S* column, results_file_value_U value)
+{
+    if (column->type == RESULTS_FILE_TYPE_INT64)
+    {
+        fprintf(out, "%" PRId64, value.i);
+    }
+    else
+    {
+        fprintf(out, "%.17g", value.d);
+    }
+}
+
+static int command_info(results_file_reader_S* reader)
+{
+    printf("rows %zu\n", results_file_row_count(reader));
+    for (int i = 0; i < results_file_column_count(reader); i++)
+    {
+        const results_file_column_S* column = results_file_column(reader, i);
+        printf("%-32s %-6s %-5s %zu bytes\n", column->name,
+               (column->type == RESULTS_FILE_TYPE_INT64) ? "int64" : "double",
+               (column->encoding == RESULTS_FILE_ENCODING_DELTA) ? "delta" : "plain",
+               results_file_column_size(reader, i));
+    }
+    return 0;
+}
+
+static int command_dump(results_file_reader_S* reader, const char* name)
+{
+    int column = results_file_find_column(reader, name);
+    if (column < 0)
+    {
+        fprintf(stderr, "No column %s\n", name);
+        return 1;
+    }
+
+    results_file_value_U* values = results_file_read_column(reader, column);
+    if (values == NULL)
+    {
+        fprintf(stderr, "Cannot read column %s\n", name);
+        return 1;
+    }
+
+    size_t rows = results_file_row_count(reader);
+    for (size_t row = 0; row < rows; row++)
+    {
+        print_value(stdout, results_file_column(reader, column), values[row]);
+        putchar('\n');
+    }
+    free(values);
+    return 0;
+}
+
+static int command_csv(results_file_reader_S* reader, int name_count, char** names)
+{
+    int count = (name_count > 0) ? name_count : results_file_column_count(reader);
+    int columns[count];
+    results_file_value_U* values[count];
+    int status = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        columns[i] = (name_count > 0) ? results_file_find_column(reader, names[i]) : i;
+        if (columns[i] < 0)
+        {
+            fprintf(stderr, "No column %s\n", names[i]);
+            return 1;
+        }
+    }
+
+    // Only the requested columns are read from disk
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = results_file_read_column(reader, columns[i]);
+        if (values[i] == NULL)
+        {
+            fprintf(stderr, "Cannot read column %s\n", results_file_column(reader, columns[i])->name);
+            status = 1;
+        }
+    }
+
+    if (status == 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            printf("%s%s", (i > 0) ? "," : "", results_file_column(reader, columns[i])->name);
+        }
+        putchar('\n');
+
+        size_t rows = results_file_row_count(reader);
+        for (size_t row = 0; row < rows; row++)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (i > 0)
+                {
+                    putchar(',');
+                }
+                print_value(stdout, results_file_column(reader, columns[i]), values[i][row]);
+            }
+            putchar('\n');
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        free(values[i]);
+    }
+    return status;
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+int main(int argc, char** argv)
+{
+    if (argc < 3 || (strcmp(argv[1], "dump") == 0 && argc != 4))
+    {
+        fprintf(stderr, "Usage: %s info <file>\n"
+                        "       %s dump <file> <column>\n"
+                        "       %s csv <file> [column...]\n", argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    results_file_reader_S* reader = results_file_open_reader(argv[2]);
+    if (reader == NULL)
+    {
+        fprintf(stderr, "%s is not a results file\n", argv[2]);
+        return 1;
+    }
+
+    int status = 1;
+    if (strcmp(argv[1], "info") == 0)
+    {
+        status = command_info(reader);
+    }
+    else if (strcmp(argv[1], "dump") == 0)
+    {
+        status = command_dump(reader, argv[3]);
+    }
+    else if (strcmp(argv[1], "csv") == 0)
+    {
+        status = command_csv(reader, argc - 3, argv + 3);
+    }
+    else
+    {
+        fprintf(stderr, "Unknown command %s\n", argv[1]);
+    }
+
+    results_file_close_reader(reader);
+    return status;
+}
@@ -0,0 +1,169 @@
+/**
+ *  @file   queueSim-top.c
+ *  @brief  Watch the telemetry page of a running simulation
+ */
+
+/*************************************************************************
+ *                           I N C L U D E S                             *
+ *************************************************************************/
+
+#include "telemetry.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+/*************************************************************************
+ *                            D E F I N E S                              *
+ *************************************************************************/
+
+#define NODES_PER_LINE (8)
+
+/*************************************************************************
+ *        P R I V A T E   F U N C T I O N   D E C L A R A T I O N S      *
+ *************************************************************************/
+
+/**
+ * @brief Print one update
+ * @param alive False once the writing process is gone without completing
+ */
+static void print_sample(const telemetry_sample_S* sample, const int64_t* backlog, bool alive);
+
+/**
+ * @brief Sleep for a number of seconds, fractions included
+ */
+static void sleep_secs(double secs);
+
+/*************************************************************************
+ *                   P R I V A T E   F U N C T I O N S                   *
+ *************************************************************************/
+
+static void print_sample(const telemetry_sample_S* sample, const int64_t* backlog, bool alive)
+{
+    int64_t total = 0, max = 0;
+    int maxNode = 0;
+
+    for (int i = 0; i < sample->N; i++)
+    {
+        total += backlog[i];
+        if (backlog[i] > max)
+        {
+            max = backlog[i];
+            maxNode = i;
+        }
+    }
+
+    printf("queueSim pid %" PRId64 "  %s\n", sample->pid,
+           (sample->state == TELEMETRY_STATE_COMPLETE) ? "complete" : alive ? "running" : "exited");
+    printf("Sim time     %.3f / %.3f (%.1f %%)\n", sample->sim_time, sample->sim_end_time,
+           (sample->sim_end_time > 0) ? 100*sample->sim_time/sample->sim_end_time : 0);
+    printf("Wall time    %.1f s\n", sample->wall_secs);
+    printf("Events       %" PRIu64 " (%.0f /s)\n", sample->events, sample->events_per_sec);
+    printf("Transmitted  %.0f\n", sample->transmitted_packets);
+    printf("Successful   %.0f\n", sample->successfully_transmitted_packets);
+    printf("Dropped      %.0f\n", sample->dropped_packets);
+    printf("Collisions   %.0f\n", sample->collisions);
+    printf("Backlog      %" PRId64 " total, %" PRId64 " most at node %d\n", total, max, maxNode);
+
+    for (int i = 0; i < sample->N; i++)
+    {
+        printf("%s%4d:%-9" PRId64, (i % NODES_PER_LINE == 0) ? "  " : "", i, backlog[i]);
+        if (i % NODES_PER_LINE == NODES_PER_LINE - 1 || i == sample->N - 1)
+        {
+            putchar('\n');
+        }
+    }
+    fflush(stdout);
+}
+
+static void sleep_secs(double secs)
+{
+    struct timespec delay = { .tv_sec = (time_t)secs, .tv_nsec = (long)((secs - (time_t)secs)*1e9) };
+
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR);
+}
+
+/*************************************************************************
+ *                    P U B L I C   F U N C T I O N S                    *
+ *************************************************************************/
+
+int main(int argc, char** argv)
+{
+    double interval = 1.0;
+    long updates = 0;
+    bool usage = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'i': interval = atof(optarg); break;
+            case 'n': updates = atol(optarg); break;
+            default: usage = true; break;
+        }
+    }
+    if (usage || optind != argc - 1 || interval <= 0 || updates < 0)
+    {
+        fprintf(stderr, "Usage: %s [-i seconds between updates] [-n updates] <telemetry name>\n", argv[0]);
+        return 1;
+    }
+
+    telemetry_reader_S* reader = telemetry_reader_open(argv[optind]);
+    if (reader == NULL)
+    {
+        fprintf(stderr, "No telemetry page %s\n", argv[optind]);
+        return 1;
+    }
+
+    int N = telemetry_reader_node_count(reader);
+    int64_t backlog[N], update[N];
+    telemetry_sample_S sample, next;
+    bool clear = isatty(STDOUT_FILENO);
+    bool seen = false;
+    int status = 0;
+
+    // Until the run completes or its process is gone, or for the number of updates asked for
+    for (long i = 0; updates == 0 || i < updates; i++)
+    {
+        if (i > 0)
+        {
+            sleep_secs(interval);
+        }
+
+        // A writer that died mid-update leaves the page torn for good, the last whole update stands
+        if (telemetry_reader_read(reader, &next, update))
+        {
+            sample = next;
+            memcpy(backlog, update, sizeof(backlog));
+            seen = true;
+        }
+        bool alive = kill((pid_t)telemetry_reader_pid(reader), 0) == 0 || errno != ESRCH;
+
+        if (!seen)
+        {
+            if (!alive)
+            {
+                fprintf(stderr, "Process of %s exited without a whole update\n", argv[optind]);
+                status = 1;
+                break;
+            }
+            continue;
+        }
+
+        fputs(clear ? "\033[H\033[2J" : (i > 0) ? "\n" : "", stdout);
+        print_sample(&sample, backlog, alive);
+        if (sample.state == TELEMETRY_STATE_COMPLETE || !alive)
+        {
+            break;
+        }
+    }
+
+    telemetry_reader_close(reader);
+    return status;
+}